@@ -1,25 +1,123 @@
 #include "Acceptor.h"
+#include "Logger.h"
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <string.h>
 
-Acceptor::Acceptor(const string &ip, unsigned short port)
-    : _addr(ip, port) {}
+Acceptor::Acceptor(const string &ip, unsigned short port, int backlog)
+    : _addr(ip, port), _sock(_addr.family(), SOCK_STREAM), _backlog(backlog), _idleFd(::open("/dev/null", O_RDONLY | O_CLOEXEC)) {}
+
+Acceptor::Acceptor(const InetAddress &addr, int backlog)
+    : _addr(addr), _sock(_addr.family(), SOCK_STREAM), _backlog(backlog), _idleFd(::open("/dev/null", O_RDONLY | O_CLOEXEC)) {}
+
+Acceptor::~Acceptor() {
+    if (_idleFd >= 0) {
+        ::close(_idleFd);
+    }
+}
+
+void Acceptor::setBacklog(int backlog) {
+    _backlog = backlog;
+}
+
+void Acceptor::setSocketOptions(const SocketOptions &opts) {
+    _options = opts;
+}
 
 // 让服务端处于监听状态
 void Acceptor::ready() {
-    setReuseAddr();
-    setReusePort();
+    if (_addr.family() == AF_UNIX) {
+        // 上次运行留下的套接字文件会让bind失败，抽象命名空间随最后一个fd关闭自动消失
+        if (_addr.isUnixPathname()) {
+            ::unlink(_addr.getIp().c_str());
+        }
+    } else {
+        setReuseAddr();
+        setReusePort();
+        if (_addr.family() == AF_INET6) {
+            setDualStack();
+        }
+    }
+    applyOptions();
+    _sock.setNonblock();
     bind();
     listen();
 }
 
-int Acceptor::accept() {
-    int ret = ::accept(_sock.getFd(), nullptr, nullptr);
+int Acceptor::accept(InetAddress *peer) {
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    int ret = ::accept4(_sock.getFd(), (struct sockaddr *)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (ret >= 0 && peer) {
+        *peer = InetAddress{(struct sockaddr *)&addr, len};
+    }
     return ret;
 }
 
+bool Acceptor::rejectOne() {
+    if (_idleFd >= 0) {
+        ::close(_idleFd);
+    }
+    int fd = ::accept4(_sock.getFd(), nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    _idleFd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    return fd >= 0;
+}
+
 int Acceptor::fd() {
     return _sock.getFd();
 }
 
+int Acceptor::getBacklog() {
+    return _backlog;
+}
+
+InetAddress &Acceptor::getAddr() {
+    return _addr;
+}
+
+bool Acceptor::attachReusePortCpuSteering(const vector<int> &groupCpus) {
+    if (groupCpus.empty()) {
+        return false;
+    }
+    // 每个CPU对应的组内序号，先绑定的优先
+    vector<int> cpuToIndex;
+    for (size_t i = 0; i < groupCpus.size(); ++i) {
+        int cpu = groupCpus[i];
+        if (cpu < 0) {
+            continue;
+        }
+        if ((size_t)cpu >= cpuToIndex.size()) {
+            cpuToIndex.resize(cpu + 1, -1);
+        }
+        if (cpuToIndex[cpu] < 0) {
+            cpuToIndex[cpu] = (int)i;
+        }
+    }
+    // A = 当前CPU，按表逐项比较：相等时返回对应序号，否则跳过这条返回指令
+    vector<struct sock_filter> code;
+    code.push_back(sock_filter{BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)});
+    for (size_t cpu = 0; cpu < cpuToIndex.size(); ++cpu) {
+        if (cpuToIndex[cpu] >= 0) {
+            code.push_back(sock_filter{BPF_JMP | BPF_JEQ | BPF_K, 0, 1, (uint32_t)cpu});
+            code.push_back(sock_filter{BPF_RET | BPF_K, 0, 0, (uint32_t)cpuToIndex[cpu]});
+        }
+    }
+    // 表中没有的CPU：A %= 组大小
+    code.push_back(sock_filter{BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)groupCpus.size()});
+    code.push_back(sock_filter{BPF_RET | BPF_A, 0, 0, 0});
+    struct sock_fprog prog;
+    prog.len = (unsigned short)code.size();
+    prog.filter = code.data();
+    if (setsockopt(_sock.getFd(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0) {
+        LOG_WARN << "SO_ATTACH_REUSEPORT_CBPF: " << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
 void Acceptor::setReuseAddr() {
     int opt = 1;
     setsockopt(_sock.getFd(), SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
@@ -30,11 +128,52 @@ void Acceptor::setReusePort() {
     setsockopt(_sock.getFd(), SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
 }
 
+void Acceptor::setDualStack() {
+    int opt = 0;
+    setsockopt(_sock.getFd(), IPPROTO_IPV6, IPV6_V6ONLY, &opt, sizeof(opt));
+}
+
+void Acceptor::applyOptions() {
+    if (_options.recvBuf > 0) {
+        setOption(SOL_SOCKET, SO_RCVBUF, &_options.recvBuf, sizeof(_options.recvBuf), "SO_RCVBUF");
+    }
+    if (_options.sendBuf > 0) {
+        setOption(SOL_SOCKET, SO_SNDBUF, &_options.sendBuf, sizeof(_options.sendBuf), "SO_SNDBUF");
+    }
+    if (_options.lingerSec >= 0) {
+        struct linger lg;
+        lg.l_onoff = 1;
+        lg.l_linger = _options.lingerSec;
+        setOption(SOL_SOCKET, SO_LINGER, &lg, sizeof(lg), "SO_LINGER");
+    }
+    if (_addr.family() == AF_UNIX) {
+        return;
+    }
+    if (_options.tcpNoDelay) {
+        int opt = 1;
+        setOption(IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt), "TCP_NODELAY");
+    }
+    if (_options.deferAcceptSec > 0) {
+        setOption(IPPROTO_TCP, TCP_DEFER_ACCEPT, &_options.deferAcceptSec, sizeof(_options.deferAcceptSec), "TCP_DEFER_ACCEPT");
+    }
+    if (_options.fastOpenQueue > 0) {
+        setOption(IPPROTO_TCP, TCP_FASTOPEN, &_options.fastOpenQueue, sizeof(_options.fastOpenQueue), "TCP_FASTOPEN");
+    }
+}
+
+void Acceptor::setOption(int level, int name, const void *value, socklen_t len, const char *what) {
+    if (setsockopt(_sock.getFd(), level, name, value, len) < 0) {
+        LOG_WARN << what << ": " << strerror(errno);
+    }
+}
+
 void Acceptor::bind() {
-    ::bind(_sock.getFd(), (struct sockaddr *)_addr.getInetAddressPtr(), sizeof(*_addr.getInetAddressPtr()));
+    if (::bind(_sock.getFd(), _addr.getSockAddr(), _addr.getSockLen()) < 0) {
+        LOG_ERROR << "bind " << _addr.toIpPort() << ": " << strerror(errno);
+    }
 }
 
 void Acceptor::listen() {
-    ::listen(_sock.getFd(), 10);
-    cout << "等待客户端连接..." << endl;
+    ::listen(_sock.getFd(), _backlog);
+    LOG_INFO << "等待客户端连接...";
 }
\ No newline at end of file
@@ -3,31 +3,73 @@
 
 #include "InetAddress.h"
 #include "Socket.h"
-#include <iostream>
+#include <linux/filter.h>
 #include <string>
+#include <vector>
 
-using std::cout;
-using std::endl;
 using std::string;
+using std::vector;
 
 class Acceptor {
 public:
-    Acceptor(const string &ip, unsigned short port);
+    // backlog：已完成三次握手、等待accept的连接队列长度
+    // ip中含':'时监听IPv6，"::"同时接受IPv4连接
+    Acceptor(const string &ip, unsigned short port, int backlog = SOMAXCONN);
+
+    // 任意地址族，Unix域地址见InetAddress::unixPath
+    explicit Acceptor(const InetAddress &addr, int backlog = SOMAXCONN);
+
+    ~Acceptor();
+
+    // 在ready()之前调用
+    void setBacklog(int backlog);
+
+    // 在ready()之前调用，listen之前设置到监听套接字上，新连接从它继承
+    void setSocketOptions(const SocketOptions &opts);
 
     void ready();
 
-    int accept();
+    // 监听套接字是非阻塞的，没有新连接时返回-1且errno为EAGAIN
+    // 新连接直接设为非阻塞、exec时关闭，peer非空时写入对端地址
+    int accept(InetAddress *peer = nullptr);
+
+    // accept因fd耗尽(EMFILE/ENFILE)失败时调用：关闭预留的fd腾出位置，accept一个连接后立即关闭，
+    // 再重新预留。否则监听套接字一直可读，水平触发下loop会空转
+    // 没有取出连接时返回false
+    bool rejectOne();
 
     int fd();
 
+    int getBacklog();
+
+    InetAddress &getAddr();
+
+    // 给SO_REUSEPORT组挂上经典BPF程序，按收到新连接的CPU选择组内的套接字
+    // groupCpus[i]是组内第i个套接字(按listen的先后顺序)所在线程绑定的CPU，-1表示没有绑定
+    // 收到连接的CPU上绑定了某个套接字的线程就交给它，同一CPU上有多个时取序号最小的；
+    // 没有任何线程绑定的CPU按(CPU % 组大小)分配，这部分连接没有局部性
+    // 对组内任意一个已listen的套接字调用一次即可
+    bool attachReusePortCpuSteering(const vector<int> &groupCpus);
+
 private:
+    InetAddress _addr; // 必须在_sock之前构造，_sock按它的地址族创建
     Socket _sock;
-    InetAddress _addr;
+    int _backlog;
+    SocketOptions _options;
+    int _idleFd; // 预留的/dev/null，fd耗尽时用来拒绝连接
 
     void setReuseAddr();
 
     void setReusePort();
 
+    // IPv6监听套接字同时接受IPv4连接
+    void setDualStack();
+
+    void applyOptions();
+
+    // 失败时打印错误，不影响监听
+    void setOption(int level, int name, const void *value, socklen_t len, const char *what);
+
     void bind();
 
     void listen();
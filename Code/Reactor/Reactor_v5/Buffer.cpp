@@ -0,0 +1,147 @@
+#include "Buffer.h"
+#include "LineScanner.h"
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+
+const size_t Buffer::kCheapPrepend;
+const size_t Buffer::kInitialSize;
+const size_t Buffer::kExtraBufSize;
+
+Buffer::Buffer(size_t initialSize)
+    : _buffer(kCheapPrepend + initialSize), _readIndex(kCheapPrepend), _writeIndex(kCheapPrepend) {}
+
+size_t Buffer::readableBytes() const {
+    return _writeIndex - _readIndex;
+}
+
+size_t Buffer::writableBytes() const {
+    return _buffer.size() - _writeIndex;
+}
+
+size_t Buffer::prependableBytes() const {
+    return _readIndex;
+}
+
+const char *Buffer::peek() const {
+    return begin() + _readIndex;
+}
+
+const char *Buffer::findEOL() const {
+    return LineScanner::find(peek(), peek() + readableBytes(), '\n');
+}
+
+size_t Buffer::findLines(vector<LineView> *lines) const {
+    return LineScanner::scanLines(peek(), readableBytes(), lines);
+}
+
+void Buffer::retrieve(size_t len) {
+    if (len < readableBytes()) {
+        _readIndex += len;
+    } else {
+        retrieveAll();
+    }
+}
+
+void Buffer::retrieveAll() {
+    _readIndex = kCheapPrepend;
+    _writeIndex = kCheapPrepend;
+}
+
+string Buffer::retrieveAsString(size_t len) {
+    len = std::min(len, readableBytes());
+    string result(peek(), len);
+    retrieve(len);
+    return result;
+}
+
+string Buffer::retrieveAllAsString() {
+    return retrieveAsString(readableBytes());
+}
+
+void Buffer::append(const char *data, size_t len) {
+    ensureWritable(len);
+    std::copy(data, data + len, beginWrite());
+    hasWritten(len);
+}
+
+void Buffer::append(const string &str) {
+    append(str.data(), str.size());
+}
+
+void Buffer::prepend(const void *data, size_t len) {
+    _readIndex -= len;
+    const char *d = static_cast<const char *>(data);
+    std::copy(d, d + len, begin() + _readIndex);
+}
+
+void Buffer::ensureWritable(size_t len) {
+    if (writableBytes() < len) {
+        makeSpace(len);
+    }
+}
+
+char *Buffer::beginWrite() {
+    return begin() + _writeIndex;
+}
+
+void Buffer::hasWritten(size_t len) {
+    _writeIndex += len;
+}
+
+ssize_t Buffer::readFd(int fd, int *savedErrno, size_t *capacity) {
+    char extraBuf[kExtraBufSize];
+    struct iovec vec[2];
+    const size_t writable = writableBytes();
+    vec[0].iov_base = beginWrite();
+    vec[0].iov_len = writable;
+    vec[1].iov_base = extraBuf;
+    vec[1].iov_len = sizeof(extraBuf);
+    // 缓冲区剩余空间已经不小于溢出区时就不用溢出区了
+    const int iovcnt = writable < sizeof(extraBuf) ? 2 : 1;
+    if (capacity) {
+        *capacity = iovcnt == 2 ? writable + sizeof(extraBuf) : writable;
+    }
+    const ssize_t n = readv(fd, vec, iovcnt);
+    if (n < 0) {
+        *savedErrno = errno;
+    } else if ((size_t)n <= writable) {
+        _writeIndex += n;
+    } else {
+        _writeIndex = _buffer.size();
+        append(extraBuf, n - writable);
+    }
+    return n;
+}
+
+void Buffer::shrink(size_t reserve) {
+    vector<char> buf(kCheapPrepend + readableBytes() + reserve);
+    std::copy(peek(), peek() + readableBytes(), buf.begin() + kCheapPrepend);
+    _writeIndex = kCheapPrepend + readableBytes();
+    _readIndex = kCheapPrepend;
+    _buffer.swap(buf);
+}
+
+size_t Buffer::internalCapacity() const {
+    return _buffer.capacity();
+}
+
+char *Buffer::begin() {
+    return &*_buffer.begin();
+}
+
+const char *Buffer::begin() const {
+    return &*_buffer.begin();
+}
+
+void Buffer::makeSpace(size_t len) {
+    if (writableBytes() + prependableBytes() < len + kCheapPrepend) {
+        _buffer.resize(_writeIndex + len);
+    } else {
+        size_t readable = readableBytes();
+        std::copy(begin() + _readIndex, begin() + _writeIndex, begin() + kCheapPrepend);
+        _readIndex = kCheapPrepend;
+        _writeIndex = _readIndex + readable;
+    }
+}
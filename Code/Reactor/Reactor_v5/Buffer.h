@@ -0,0 +1,87 @@
+#ifndef _BUFFER_H
+#define _BUFFER_H
+
+#include "LineScanner.h"
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// 网络缓冲区
+// +-------------------+------------------+------------------+
+// | prependable bytes |  readable bytes  |  writable bytes  |
+// +-------------------+------------------+------------------+
+// 0             _readIndex         _writeIndex          size()
+// 头部预留kCheapPrepend字节，可以在已写好的数据前面廉价地补上长度等头部
+class Buffer {
+public:
+    static const size_t kCheapPrepend = 8;
+    static const size_t kInitialSize = 1024;
+    static const size_t kExtraBufSize = 65536; // readFd使用的栈上溢出区
+
+    explicit Buffer(size_t initialSize = kInitialSize);
+
+    size_t readableBytes() const;
+
+    size_t writableBytes() const;
+
+    size_t prependableBytes() const;
+
+    // 可读数据的起始位置
+    const char *peek() const;
+
+    // 第一个'\n'的位置，没有时返回nullptr
+    const char *findEOL() const;
+
+    // 把可读数据中所有完整的行追加到lines，返回它们占用的字节数
+    // 用完lines之后再retrieve这么多字节
+    size_t findLines(vector<LineView> *lines) const;
+
+    void retrieve(size_t len);
+
+    void retrieveAll();
+
+    string retrieveAsString(size_t len);
+
+    string retrieveAllAsString();
+
+    void append(const char *data, size_t len);
+
+    void append(const string &str);
+
+    // 在可读数据前面写入len字节，len不能超过prependableBytes()
+    void prepend(const void *data, size_t len);
+
+    void ensureWritable(size_t len);
+
+    // 释放多余的空间，只保留可读数据和reserve字节的可写空间
+    void shrink(size_t reserve);
+
+    // 底层数组的大小
+    size_t internalCapacity() const;
+
+    char *beginWrite();
+
+    void hasWritten(size_t len);
+
+    // 一次readv读入缓冲区剩余空间和64KB栈上溢出区，溢出部分再追加进来
+    // 返回read的结果，出错时错误码写入savedErrno
+    // capacity非空时写入这次readv实际提供的空间，返回值等于它说明内核中可能还有数据
+    ssize_t readFd(int fd, int *savedErrno, size_t *capacity = nullptr);
+
+private:
+    vector<char> _buffer;
+    size_t _readIndex;
+    size_t _writeIndex;
+
+    char *begin();
+
+    const char *begin() const;
+
+    // 腾出len字节可写空间：前面空闲的够用就把数据搬到前面，否则扩容
+    void makeSpace(size_t len);
+};
+
+#endif
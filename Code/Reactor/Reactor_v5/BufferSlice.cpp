@@ -0,0 +1,36 @@
+#include "BufferSlice.h"
+#include <algorithm>
+
+BufferSlice::BufferSlice() : _offset(0), _len(0) {}
+
+BufferSlice::BufferSlice(string &&data)
+    : _storage(std::make_shared<const string>(std::move(data))), _offset(0), _len(_storage->size()) {}
+
+BufferSlice::BufferSlice(const char *data, size_t len)
+    : _storage(std::make_shared<const string>(data, len)), _offset(0), _len(len) {}
+
+BufferSlice::BufferSlice(const shared_ptr<const string> &storage)
+    : _storage(storage), _offset(0), _len(storage ? storage->size() : 0) {}
+
+const char *BufferSlice::data() const {
+    return _storage ? _storage->data() + _offset : nullptr;
+}
+
+size_t BufferSlice::size() const {
+    return _len;
+}
+
+bool BufferSlice::empty() const {
+    return _len == 0;
+}
+
+BufferSlice BufferSlice::slice(size_t offset, size_t len) const {
+    BufferSlice sub(*this);
+    sub._offset = _offset + std::min(offset, _len);
+    sub._len = std::min(len, _len - (sub._offset - _offset));
+    return sub;
+}
+
+long BufferSlice::useCount() const {
+    return _storage.use_count();
+}
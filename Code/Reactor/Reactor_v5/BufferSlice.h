@@ -0,0 +1,43 @@
+#ifndef _BUFFER_SLICE_H
+#define _BUFFER_SLICE_H
+
+#include <memory>
+#include <stddef.h>
+#include <string>
+
+using std::shared_ptr;
+using std::string;
+
+// 引用计数的只读字节片段
+// 拷贝只增加引用计数，同一份数据可以同时排在多个连接的输出队列里
+// 底层数据创建后不再修改，也不会被移动，可以跨线程共享
+class BufferSlice {
+public:
+    BufferSlice();
+
+    // 接管字符串的内存，只在这里分配一次
+    explicit BufferSlice(string &&data);
+
+    BufferSlice(const char *data, size_t len);
+
+    BufferSlice(const shared_ptr<const string> &storage);
+
+    const char *data() const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+    // 同一份数据中[offset, offset + len)的子片段，不拷贝
+    BufferSlice slice(size_t offset, size_t len) const;
+
+    // 共享同一份数据的片段个数
+    long useCount() const;
+
+private:
+    shared_ptr<const string> _storage;
+    size_t _offset;
+    size_t _len;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "Codec.h"
+#include "LineScanner.h"
+#include <arpa/inet.h>
+#include <string.h>
+
+LineCodec::LineCodec(size_t maxLineLength) : _maxLineLength(maxLineLength) {}
+
+ssize_t LineCodec::decode(const char *data, size_t len, vector<Frame> *frames) const {
+    // 同一个Codec由所有EventLoop共享，临时数组按线程各一份，跨调用复用
+    static thread_local vector<LineView> lines;
+    lines.clear();
+    size_t used = LineScanner::scanLines(data, len, &lines);
+    if (len - used > _maxLineLength) {
+        return -1;
+    }
+    for (const LineView &line : lines) {
+        size_t lineLen = line.len;
+        if (lineLen > 0 && line.data[lineLen - 1] == '\r') {
+            --lineLen;
+        }
+        frames->push_back(Frame{line.data, lineLen});
+    }
+    return used;
+}
+
+string LineCodec::encode(const string &msg) const {
+    string out;
+    out.reserve(msg.size() + 1);
+    out.append(msg);
+    out.push_back('\n');
+    return out;
+}
+
+LengthFieldCodec::LengthFieldCodec(LengthType type, size_t maxFrameLength)
+    : _type(type), _maxFrameLength(maxFrameLength) {}
+
+int LengthFieldCodec::parseLength(const char *data, size_t len, uint64_t *frameLength) const {
+    if (_type == LengthType::Fixed32) {
+        if (len < sizeof(uint32_t)) {
+            return 0;
+        }
+        uint32_t be32;
+        memcpy(&be32, data, sizeof(be32));
+        *frameLength = ntohl(be32);
+        return sizeof(uint32_t);
+    }
+    uint64_t value = 0;
+    // 64位长度最多需要10个字节
+    for (size_t i = 0; i < len && i < 10; ++i) {
+        uint8_t byte = static_cast<uint8_t>(data[i]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+        if (!(byte & 0x80)) {
+            *frameLength = value;
+            return i + 1;
+        }
+    }
+    return len >= 10 ? -1 : 0;
+}
+
+ssize_t LengthFieldCodec::decode(const char *data, size_t len, vector<Frame> *frames) const {
+    size_t offset = 0;
+    while (offset < len) {
+        uint64_t frameLength = 0;
+        int headerLen = parseLength(data + offset, len - offset, &frameLength);
+        if (headerLen < 0 || frameLength > _maxFrameLength) {
+            return -1;
+        }
+        if (headerLen == 0 || len - offset - headerLen < frameLength) {
+            break; // 帧还没收全
+        }
+        frames->push_back(Frame{data + offset + headerLen, static_cast<size_t>(frameLength)});
+        offset += headerLen + frameLength;
+    }
+    return offset;
+}
+
+string LengthFieldCodec::encode(const string &msg) const {
+    string out;
+    if (_type == LengthType::Fixed32) {
+        uint32_t be32 = htonl(static_cast<uint32_t>(msg.size()));
+        out.reserve(sizeof(be32) + msg.size());
+        out.append(reinterpret_cast<const char *>(&be32), sizeof(be32));
+    } else {
+        uint64_t value = msg.size();
+        out.reserve(10 + msg.size());
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+    out.append(msg);
+    return out;
+}
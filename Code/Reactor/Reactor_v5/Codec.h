@@ -0,0 +1,81 @@
+#ifndef _CODEC_H
+#define _CODEC_H
+
+#include <functional>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+class TcpConnection;
+
+// 一帧完整的消息，指向连接输入缓冲区内的负载，不含分隔符或长度头
+// 只在帧回调返回前有效，需要交给其他线程时调用retain()拷贝出来
+struct Frame {
+    const char *data;
+    size_t len;
+
+    string retain() const {
+        return string(data, len);
+    }
+};
+
+using FrameCallback = std::function<void(const shared_ptr<TcpConnection> &, const Frame &)>;
+
+// 位于EventLoop::handelMessage和用户回调之间，负责从输入缓冲区切出完整的帧
+// 解码不修改Codec本身，同一个Codec可以被多个EventLoop线程共享
+class Codec {
+public:
+    virtual ~Codec() {}
+
+    // 把[data, data + len)中所有完整的帧追加到frames，返回这些帧占用的字节数，
+    // 剩余不完整的部分留在缓冲区等待更多数据；数据不合法时返回-1，连接将被关闭
+    virtual ssize_t decode(const char *data, size_t len, vector<Frame> *frames) const = 0;
+
+    // 把一条消息编码成可以直接发送的字节
+    virtual string encode(const string &msg) const = 0;
+};
+
+// 以'\n'分隔的文本行，行尾的'\r'会被去掉
+class LineCodec : public Codec {
+public:
+    // 超过maxLineLength仍没有'\n'视为非法数据
+    explicit LineCodec(size_t maxLineLength = 1024 * 1024);
+
+    ssize_t decode(const char *data, size_t len, vector<Frame> *frames) const override;
+
+    string encode(const string &msg) const override;
+
+private:
+    size_t _maxLineLength;
+};
+
+// 长度头+负载，长度头为4字节网络字节序或varint(每字节低7位，最高位表示后面还有)
+class LengthFieldCodec : public Codec {
+public:
+    enum class LengthType {
+        Fixed32,
+        Varint
+    };
+
+    explicit LengthFieldCodec(LengthType type = LengthType::Fixed32, size_t maxFrameLength = 64 * 1024 * 1024);
+
+    ssize_t decode(const char *data, size_t len, vector<Frame> *frames) const override;
+
+    string encode(const string &msg) const override;
+
+private:
+    LengthType _type;
+    size_t _maxFrameLength;
+
+    // 解析长度头，成功返回头部字节数，数据不够返回0，非法返回-1
+    int parseLength(const char *data, size_t len, uint64_t *frameLength) const;
+};
+
+#endif //_CODEC_H
@@ -0,0 +1,44 @@
+#include "ConnectionPool.h"
+#include "TcpConnection.h"
+
+ConnectionPool::ConnectionPool() : _capacity(0), _acquired(0) {}
+
+void ConnectionPool::setCapacity(size_t capacity) {
+    _capacity = capacity;
+    if (_free.size() > _capacity) {
+        _free.resize(_capacity);
+    }
+}
+
+size_t ConnectionPool::capacity() {
+    return _capacity;
+}
+
+shared_ptr<TcpConnection> ConnectionPool::acquire() {
+    if (_free.empty()) {
+        return nullptr;
+    }
+    ++_acquired;
+    shared_ptr<TcpConnection> conn = std::move(_free.back());
+    _free.pop_back();
+    return conn;
+}
+
+void ConnectionPool::release(shared_ptr<TcpConnection> &&conn) {
+    if (!conn || conn.use_count() != 1 || _free.size() >= _capacity) {
+        return;
+    }
+    conn->recycle();
+    _free.push_back(std::move(conn));
+}
+
+void ConnectionPool::trim() {
+    if (_acquired == 0 && !_free.empty()) {
+        _free.resize(_free.size() / 2);
+    }
+    _acquired = 0;
+}
+
+size_t ConnectionPool::size() {
+    return _free.size();
+}
@@ -0,0 +1,43 @@
+#ifndef _CONNECTION_POOL_H
+#define _CONNECTION_POOL_H
+
+#include <memory>
+#include <vector>
+
+using std::shared_ptr;
+using std::vector;
+
+class TcpConnection;
+
+// 每个EventLoop一个，回收已关闭的TcpConnection
+// 连回shared_ptr的控制块一起复用，稳定状态下建立连接不需要分配内存
+// 只在EventLoop线程中使用，不加锁
+class ConnectionPool {
+public:
+    ConnectionPool();
+
+    // 最多缓存capacity个空闲连接对象，0表示不回收
+    void setCapacity(size_t capacity);
+
+    size_t capacity();
+
+    // 取出一个空闲对象，没有时返回空
+    shared_ptr<TcpConnection> acquire();
+
+    // 回收已关闭的连接：只有调用者持有最后一个引用时才能复用，
+    // 线程池任务等还持有引用的对象交给shared_ptr正常析构
+    void release(shared_ptr<TcpConnection> &&conn);
+
+    // 定期调用：上个周期没有取过对象说明连接已不活跃，释放一半空闲对象
+    void trim();
+
+    // 当前缓存的空闲对象个数
+    size_t size();
+
+private:
+    vector<shared_ptr<TcpConnection>> _free;
+    size_t _capacity;
+    size_t _acquired; // 上次trim以来取出的次数
+};
+
+#endif
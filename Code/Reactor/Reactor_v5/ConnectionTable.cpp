@@ -0,0 +1,52 @@
+#include "ConnectionTable.h"
+#include "TcpConnection.h"
+#include <algorithm>
+
+ConnectionTable::ConnectionTable() : _size(0) {}
+
+ConnId ConnectionTable::insert(int fd, const shared_ptr<TcpConnection> &conn) {
+    if ((size_t)fd >= _slots.size()) {
+        _slots.resize(std::max((size_t)fd + 1, 2 * _slots.size()));
+    }
+    Slot &slot = _slots[fd];
+    if (!slot.conn) {
+        ++_size;
+    }
+    slot.conn = conn;
+    return ((ConnId)slot.generation << 32) | (uint32_t)fd;
+}
+
+TcpConnection *ConnectionTable::find(int fd) {
+    if (fd < 0 || (size_t)fd >= _slots.size()) {
+        return nullptr;
+    }
+    return _slots[fd].conn.get();
+}
+
+shared_ptr<TcpConnection> ConnectionTable::get(ConnId id) {
+    int fd = fdOf(id);
+    if ((size_t)fd >= _slots.size() || _slots[fd].generation != (uint32_t)(id >> 32)) {
+        return nullptr;
+    }
+    return _slots[fd].conn;
+}
+
+shared_ptr<TcpConnection> ConnectionTable::erase(int fd) {
+    if (fd < 0 || (size_t)fd >= _slots.size() || !_slots[fd].conn) {
+        return nullptr;
+    }
+    // 先移出再交给调用者，避免析构过程中访问到半删除的槽位
+    shared_ptr<TcpConnection> temp;
+    temp.swap(_slots[fd].conn);
+    ++_slots[fd].generation;
+    --_size;
+    return temp;
+}
+
+size_t ConnectionTable::size() {
+    return _size;
+}
+
+int ConnectionTable::fdOf(ConnId id) {
+    return (int)(uint32_t)id;
+}
@@ -0,0 +1,59 @@
+#ifndef _CONNECTION_TABLE_H
+#define _CONNECTION_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using std::shared_ptr;
+using std::vector;
+
+class TcpConnection;
+
+// 连接编号：高32位为代数(generation)，低32位为fd
+// fd被关闭后会被内核复用，代数用来识别已经失效的旧编号
+using ConnId = uint64_t;
+
+// 以fd为下标的连接表
+// fd是从小到大分配的稠密整数，直接用连续的vector存放，查找不需要比较和指针跳转
+class ConnectionTable {
+public:
+    ConnectionTable();
+
+    // 插入连接，返回该连接的编号
+    ConnId insert(int fd, const shared_ptr<TcpConnection> &conn);
+
+    // 按fd查找，不存在时返回nullptr
+    TcpConnection *find(int fd);
+
+    // 按编号查找，连接已关闭或fd已被复用时返回空
+    shared_ptr<TcpConnection> get(ConnId id);
+
+    // 移除连接并把它交给调用者，由调用者决定析构还是回收
+    shared_ptr<TcpConnection> erase(int fd);
+
+    size_t size();
+
+    // 依次对每个连接调用func(TcpConnection *)，遍历期间不能插入或移除
+    template <typename Func>
+    void forEach(Func func) {
+        for (Slot &slot : _slots) {
+            if (slot.conn) {
+                func(slot.conn.get());
+            }
+        }
+    }
+
+    static int fdOf(ConnId id);
+
+private:
+    struct Slot {
+        shared_ptr<TcpConnection> conn;
+        uint32_t generation = 0;
+    };
+
+    vector<Slot> _slots;
+    size_t _size;
+};
+
+#endif
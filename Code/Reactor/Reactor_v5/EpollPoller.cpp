@@ -0,0 +1,40 @@
+#include "EpollPoller.h"
+#include "Logger.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+EpollPoller::EpollPoller() : _epfd(epoll_create1(EPOLL_CLOEXEC)) {
+    if (_epfd < 0) {
+        LOG_ERROR << "epoll_create1: " << strerror(errno);
+        throw "epoll创建失败";
+    }
+}
+
+EpollPoller::~EpollPoller() {
+    close(_epfd);
+}
+
+void EpollPoller::addFd(int fd, uint32_t events) {
+    epoll_event event;
+    event.events = events;
+    event.data.fd = fd;
+    epoll_ctl(_epfd, EPOLL_CTL_ADD, fd, &event);
+}
+
+void EpollPoller::modFd(int fd, uint32_t events) {
+    epoll_event event;
+    event.events = events;
+    event.data.fd = fd;
+    epoll_ctl(_epfd, EPOLL_CTL_MOD, fd, &event);
+}
+
+void EpollPoller::delFd(int fd) {
+    epoll_event event;
+    event.data.fd = fd;
+    epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, &event);
+}
+
+int EpollPoller::poll(struct epoll_event *events, int maxEvents, int timeoutMs) {
+    return epoll_wait(_epfd, events, maxEvents, timeoutMs);
+}
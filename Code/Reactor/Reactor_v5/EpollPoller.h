@@ -0,0 +1,24 @@
+#ifndef _EPOLL_POLLER_H
+#define _EPOLL_POLLER_H
+
+#include "Poller.h"
+
+class EpollPoller : public Poller {
+public:
+    EpollPoller();
+
+    ~EpollPoller();
+
+    void addFd(int fd, uint32_t events) override;
+
+    void modFd(int fd, uint32_t events) override;
+
+    void delFd(int fd) override;
+
+    int poll(struct epoll_event *events, int maxEvents, int timeoutMs) override;
+
+private:
+    int _epfd;
+};
+
+#endif
@@ -1,50 +1,128 @@
 #include "EventLoop.h"
 #include "Acceptor.h"
+#include "EventLoopThreadPool.h"
+#include "Logger.h"
 #include "TcpConnection.h"
+#include <algorithm>
+#include <signal.h>
+#include <string.h>
 
-EventLoop::EventLoop(Acceptor &acceptor, size_t maxEvents)
-    : _epfd(createEpoll()), _isLooping(false), _acceptor(acceptor), _eventFd(createEventFd()) {
+namespace {
+
+// sendfile不能带MSG_NOSIGNAL，对端RST之后再发送会产生SIGPIPE，默认处理是终止整个进程
+// 进程中第一个EventLoop构造时忽略它一次，之后写已关闭的连接只会返回EPIPE
+void ignoreSigPipe() {
+    static bool ignored = (::signal(SIGPIPE, SIG_IGN), true);
+    (void)ignored;
+}
+
+}
+
+EventLoop::EventLoop(Acceptor &acceptor, size_t maxEvents, PollerType pollerType)
+    : _poller(Poller::newPoller(pollerType)), _completions(_poller->completions()), _isLooping(false), _threadId(std::thread::id()), _acceptor(&acceptor), _threadPool(nullptr), _connCount(0), _edgeTriggered(false), _nextTimerId(0), _busyPollSpin(0), _spinBudget(0), _sockBusyPollUs(0), _zeroCopyThreshold(0), _quickAck(false), _spinPolls(0), _spinWakeups(0), _sleepWakeups(0), _eventFd(createEventFd()), _wakeupPending(false) {
+    if (maxEvents == 0) {
+        throw "构造参数错误";
+    }
+    ignoreSigPipe();
+    _epollEvents.resize(maxEvents);
+    _poller->addListener(_acceptor->fd());
+    addFd(_eventFd);
+    addFd(_timerQueue.fd());
+}
+
+EventLoop::EventLoop(size_t maxEvents, PollerType pollerType)
+    : _poller(Poller::newPoller(pollerType)), _completions(_poller->completions()), _isLooping(false), _threadId(std::thread::id()), _acceptor(nullptr), _threadPool(nullptr), _connCount(0), _edgeTriggered(false), _nextTimerId(0), _busyPollSpin(0), _spinBudget(0), _sockBusyPollUs(0), _zeroCopyThreshold(0), _quickAck(false), _spinPolls(0), _spinWakeups(0), _sleepWakeups(0), _eventFd(createEventFd()), _wakeupPending(false) {
     if (maxEvents == 0) {
         throw "构造参数错误";
     }
-    _epollEvents.reserve(maxEvents);
-    addFd(_acceptor.fd());
+    ignoreSigPipe();
+    _epollEvents.resize(maxEvents);
     addFd(_eventFd);
+    addFd(_timerQueue.fd());
 }
 
 EventLoop::~EventLoop() {
-    close(_epfd);
+    // 先关闭Poller：io_uring的请求还引用着连接的输出数据，要在连接析构之前取消
+    _poller.reset();
     close(_eventFd);
 }
 
 // 持续wait()监听
 void EventLoop::loop() {
+    _threadId = std::this_thread::get_id();
     _isLooping = true;
     while (_isLooping) {
         wait();
     }
 }
 
+// 可能由其他线程调用，需要唤醒阻塞在epoll_wait上的线程
 void EventLoop::unLoop() {
     _isLooping = false;
+    wakeup();
 }
 
 void EventLoop::setNewConnectionCallback(functionCallback &&func) {
-    _newConnection = std::move(func);
+    _callbacks.newConnection = std::move(func);
 }
 
 void EventLoop::setMessageCallback(functionCallback &&func) {
-    _message = std::move(func);
+    _callbacks.message = std::move(func);
 }
 
 void EventLoop::setCloseCallback(functionCallback &&func) {
-    _close = std::move(func);
+    _callbacks.close = std::move(func);
+}
+
+void EventLoop::setWriteCompleteCallback(functionCallback &&func) {
+    _callbacks.writeComplete = std::move(func);
+}
+
+void EventLoop::queueFlush(const shared_ptr<TcpConnection> &conn) {
+    _dirtyConns.push_back(conn);
+}
+
+void EventLoop::broadcast(vector<shared_ptr<TcpConnection>> &&conns, const BufferSlice &payload) {
+    runInLoop(std::bind(&EventLoop::sendToConnections, this, std::move(conns), payload));
+}
+
+void EventLoop::broadcastAll(const BufferSlice &payload) {
+    runInLoop(std::bind(&EventLoop::sendToAll, this, payload));
+}
+
+void EventLoop::sendToConnections(vector<shared_ptr<TcpConnection>> &conns, const BufferSlice &payload) {
+    for (const shared_ptr<TcpConnection> &conn : conns) {
+        conn->send(payload);
+    }
+}
+
+void EventLoop::sendToAll(const BufferSlice &payload) {
+    _conns.forEach([&payload](TcpConnection *conn) {
+        conn->send(payload);
+    });
+}
+
+void EventLoop::setCodec(const shared_ptr<Codec> &codec, FrameCallback &&frameCallback) {
+    _codec = codec;
+    _frame = std::move(frameCallback);
+}
+
+void EventLoop::setHighWaterMarkCallback(functionCallback &&func) {
+    _callbacks.highWaterMark = std::move(func);
+}
+
+void EventLoop::setLowWaterMarkCallback(functionCallback &&func) {
+    _callbacks.lowWaterMark = std::move(func);
+}
+
+void EventLoop::setWaterMarks(const WaterMarks &marks) {
+    _waterMarks = marks;
 }
 
 int EventLoop::createEventFd() {
     int fd = eventfd(0, 0);
     if (fd < 0) {
-        perror("createEventFd: ");
+        LOG_ERROR << "eventfd: " << strerror(errno);
         return -1;
     } else {
         return fd;
@@ -55,7 +133,7 @@ void EventLoop::handleRead() {
     uint64_t one = 1;
     ssize_t ret = read(_eventFd, &one, sizeof(uint64_t));
     if (ret != sizeof(uint64_t)) {
-        perror("handleRead: ");
+        LOG_ERROR << "eventfd read: " << strerror(errno);
     }
 }
 
@@ -63,69 +141,432 @@ void EventLoop::wakeup() {
     uint64_t one = 1;
     ssize_t ret = write(_eventFd, &one, sizeof(uint64_t));
     if (ret != sizeof(uint64_t)) {
-        perror("wakeup: ");
+        LOG_ERROR << "eventfd write: " << strerror(errno);
     }
 }
 
 void EventLoop::doPendingTasks() {
-    vector<Task> temp;
-    std::unique_lock<mutex> ul{_mutex};
-    temp.swap(_pendings);
-    ul.unlock();
+    // 先清除标记再取任务：此后入队的任务若没被这一轮取到，生产者一定会再次唤醒
+    _wakeupPending.store(false, std::memory_order_seq_cst);
+    size_t count = _pendings.consume([this](PendingTask &pending) {
+        auto delay = std::chrono::steady_clock::now() - pending.queuedAt;
+        _stats.recordPendingDelay(std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count());
+        pending.task();
+    });
+    _stats.recordDrain(count);
+}
 
-    for (auto &func : temp) {
-        func();
+void EventLoop::runInLoop(Task &&task) {
+    if (isInLoopThread()) {
+        task();
+    } else {
+        queueInLoop(std::move(task));
     }
 }
 
-void EventLoop::runInLoop(Task &&task) {
-    std::unique_lock<mutex> ul{_mutex};
-    _pendings.push_back(std::move(task));
-    ul.unlock();
-    wakeup();
+void EventLoop::queueInLoop(Task &&task) {
+    _pendings.push(PendingTask{std::move(task), std::chrono::steady_clock::now()});
+    // 只有第一个生产者需要写eventfd，合并唤醒
+    if (!_wakeupPending.exchange(true, std::memory_order_seq_cst)) {
+        wakeup();
+    }
 }
 
+bool EventLoop::isInLoopThread() {
+    return _threadId.load(std::memory_order_relaxed) == std::this_thread::get_id();
+}
+
+void EventLoop::setThreadPool(EventLoopThreadPool *pool) {
+    _threadPool = pool;
+}
+
+void EventLoop::queueConnection(int fd, const InetAddress &peer) {
+    ++_connCount;
+    runInLoop(std::bind(&EventLoop::establishConnection, this, fd, peer));
+}
+
+size_t EventLoop::connectionCount() {
+    return _connCount;
+}
+
+void EventLoop::setEdgeTriggered(bool on) {
+    _edgeTriggered = on;
+}
+
+shared_ptr<TcpConnection> EventLoop::findConnection(ConnId id) {
+    return _conns.get(id);
+}
+
+TimerId EventLoop::runAt(Timestamp when, TimerCallback &&cb) {
+    return addTimer(when, Interval::zero(), std::move(cb));
+}
+
+TimerId EventLoop::runAfter(Interval delay, TimerCallback &&cb) {
+    return addTimer(std::chrono::steady_clock::now() + delay, Interval::zero(), std::move(cb));
+}
+
+TimerId EventLoop::runEvery(Interval interval, TimerCallback &&cb) {
+    if (interval <= Interval::zero()) {
+        throw "定时器间隔必须大于0";
+    }
+    return addTimer(std::chrono::steady_clock::now() + interval, interval, std::move(cb));
+}
+
+void EventLoop::cancel(TimerId id) {
+    runInLoop(std::bind(&TimerQueue::cancel, &_timerQueue, id));
+}
+
+void EventLoop::setBusyPoll(Interval spin, int sockBusyPollUs) {
+    _busyPollSpin = spin;
+    _spinBudget = spin;
+    _sockBusyPollUs = sockBusyPollUs;
+}
+
+void EventLoop::setConnectionPool(size_t capacity, Interval trimInterval) {
+    _connPool.setCapacity(capacity);
+    if (capacity > 0 && trimInterval > Interval::zero()) {
+        runEvery(trimInterval, std::bind(&ConnectionPool::trim, &_connPool));
+    }
+}
+
+void EventLoop::setZeroCopy(size_t threshold) {
+    if (threshold > 0 && _completions) {
+        LOG_WARN << "io_uring完成模式不支持MSG_ZEROCOPY，忽略零拷贝设置";
+        return;
+    }
+    _zeroCopyThreshold = threshold;
+}
+
+void EventLoop::setQuickAck(bool on) {
+    _quickAck = on;
+}
+
+LoopStatsSnapshot EventLoop::getStats() {
+    return _stats.snapshot();
+}
+
+BusyPollStats EventLoop::getBusyPollStats() {
+    BusyPollStats stats;
+    stats.spinPolls = _spinPolls.load(std::memory_order_relaxed);
+    stats.spinWakeups = _spinWakeups.load(std::memory_order_relaxed);
+    stats.sleepWakeups = _sleepWakeups.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// 定时器队列只在EventLoop线程中修改，其他线程通过runInLoop转交
+TimerId EventLoop::addTimer(Timestamp when, Interval interval, TimerCallback &&cb) {
+    TimerId id = ++_nextTimerId;
+    TimerQueue *queue = &_timerQueue;
+    runInLoop([queue, id, when, interval, cb]() mutable {
+        queue->addTimer(id, when, interval, std::move(cb));
+    });
+    return id;
+}
+
+// 一次事件把已完成握手的连接全部accept，直到EAGAIN
 void EventLoop::handelNewConnection() {
-    int connFd = _acceptor.accept();
-    addFd(connFd);
-    _conns[connFd] = std::make_shared<TcpConnection>(connFd, this);
-    cout << _conns[connFd]->toString() << "建立连接" << endl;
+    InetAddress peer;
+    while (true) {
+        int connFd = _acceptor->accept(&peer);
+        if (connFd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE) {
+                LOG_WARN << "文件描述符耗尽，拒绝新连接";
+                if (_acceptor->rejectOne()) {
+                    continue;
+                }
+                break;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_WARN << "accept: " << strerror(errno);
+            }
+            break;
+        }
+        dispatchConnection(connFd, peer);
+    }
+}
 
-    _conns[connFd]->setNewConnectionCallback(_newConnection);
-    _conns[connFd]->setMessageCallback(_message);
-    _conns[connFd]->setCloseCallback(_close);
+void EventLoop::dispatchConnection(int connFd, const InetAddress &peer) {
+    EventLoop *ioLoop = _threadPool ? _threadPool->getNextLoop() : nullptr;
+    if (ioLoop) {
+        // 多Reactor模式：主Reactor只accept，连接交给子Reactor
+        ioLoop->queueConnection(connFd, peer);
+    } else {
+        ++_connCount;
+        establishConnection(connFd, peer);
+    }
+}
+
+void EventLoop::establishConnection(int connFd, const InetAddress &peer) {
+    shared_ptr<TcpConnection> conn = _connPool.acquire();
+    if (conn) {
+        conn->reset(connFd, peer);
+    } else {
+        conn = std::make_shared<TcpConnection>(connFd, this, peer);
+    }
+    conn->setId(_conns.insert(connFd, conn));
+    if (_edgeTriggered) {
+        conn->setEdgeTriggered();
+    }
+    if (_completions) {
+        conn->enableAsyncSend();
+    }
+    _poller->addConnection(connFd, conn->getEvents());
+    if (_sockBusyPollUs > 0) {
+        setsockopt(connFd, SOL_SOCKET, SO_BUSY_POLL, &_sockBusyPollUs, sizeof(_sockBusyPollUs));
+    }
+    if (_zeroCopyThreshold > 0) {
+        conn->enableZeroCopy(_zeroCopyThreshold);
+    }
+    if (_quickAck) {
+        conn->setQuickAck();
+    }
+    // 每个连接都会走到这里，只记对端地址和fd，不调用toString
+    LOG_DEBUG << conn->getPeerAddr().toIpPort() << " fd=" << connFd << " 建立连接";
 
-    _conns[connFd]->newConnectionCallback();
+    conn->setCallbacks(&_callbacks);
+    conn->setWaterMarks(_waterMarks.high, _waterMarks.low, _waterMarks.pauseReading);
+
+    conn->newConnectionCallback();
 }
 
 void EventLoop::handelMessage(int fd) {
-    if (_conns.count(fd)) {
-        if (!_conns[fd]->isClosed()) {
-            _conns[fd]->messageCallback();
+    // 每个事件只做一次下标查找
+    TcpConnection *conn = _conns.find(fd);
+    if (!conn || conn->isDisconnected()) {
+        return;
+    }
+    if (conn->peerClosed()) {
+        // 半关闭等待发送期间又收到EPOLLHUP/EPOLLERR，连接已彻底断开
+        closeConnection(conn, fd);
+        return;
+    }
+    // 不再用MSG_PEEK探测，read返回0就是EOF
+    // 边缘触发只通知一次，readToBuffer会读到内核缓冲区为空
+    handelInput(conn, fd, conn->readToBuffer());
+}
+
+void EventLoop::handelInput(TcpConnection *conn, int fd, int bytes) {
+    if (bytes > 0) {
+        if (!_codec) {
+            conn->messageCallback();
+        } else if (!handelFrames(conn)) {
+            closeConnection(conn, fd);
+            return;
+        }
+    }
+    if (conn->peerClosed()) {
+        if (!conn->readyToClose()) {
+            // 对端只是关闭了写端，把已经排队的回复发完再关闭
+            conn->stopReading();
         } else {
-            cout << _conns[fd]->toString() << "断开连接" << endl;
-            _conns[fd]->closeCallback();
-            delFd(fd);
-            _conns.erase(fd);
+            closeConnection(conn, fd);
+        }
+    }
+}
+
+size_t EventLoop::completionCount() {
+    return _completions ? _completions->size() : 0;
+}
+
+void EventLoop::handelCompletions() {
+    for (const Completion &completion : *_completions) {
+        switch (completion.type) {
+        case CompletionType::Accept:
+            handelAccepted(completion.res);
+            break;
+        case CompletionType::Recv:
+            handelReceived(completion.fd, completion.data, completion.res);
+            break;
+        case CompletionType::Send:
+            handelSent(completion.fd, completion.res);
+            break;
         }
     }
 }
 
-int EventLoop::createEpoll() {
-    return epoll_create(1);
+// multishot accept每个新连接一个完成事件，拿不到对端地址，用getpeername补上
+void EventLoop::handelAccepted(int connFd) {
+    if (connFd < 0) {
+        int err = -connFd;
+        if (err == EMFILE || err == ENFILE) {
+            LOG_WARN << "文件描述符耗尽，拒绝新连接";
+            _acceptor->rejectOne();
+        } else if (err != ECONNABORTED && err != EINTR && err != EAGAIN) {
+            LOG_WARN << "accept: " << strerror(err);
+        }
+        return;
+    }
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getpeername(connFd, (struct sockaddr *)&addr, &len) < 0) {
+        close(connFd); // 握手后对端已经断开
+        return;
+    }
+    dispatchConnection(connFd, InetAddress((struct sockaddr *)&addr, len));
+}
+
+// 数据在Poller的缓冲区里，下一次poll()前拷进输入缓冲区
+// 暂停读取时取消recv之前已经读出的数据也从这里到达，照常交给回调
+void EventLoop::handelReceived(int fd, const char *data, int len) {
+    TcpConnection *conn = _conns.find(fd);
+    if (!conn || conn->isDisconnected()) {
+        return;
+    }
+    handelInput(conn, fd, conn->appendInput(data, len));
+}
+
+void EventLoop::handelSent(int fd, int res) {
+    TcpConnection *conn = _conns.find(fd);
+    if (!conn) {
+        return;
+    }
+    conn->sendComplete(res);
+    if (conn->isDisconnected()) {
+        // closeConnection在等这次发送结束
+        if (!conn->sendInFlight()) {
+            finishClose(conn, fd);
+        }
+    } else if (conn->readyToClose()) {
+        closeConnection(conn, fd);
+    }
+}
+
+bool EventLoop::handelFrames(TcpConnection *conn) {
+    Buffer *input = conn->inputBuffer();
+    _frames.clear();
+    ssize_t used = _codec->decode(input->peek(), input->readableBytes(), &_frames);
+    if (used < 0) {
+        LOG_WARN << conn->getPeerAddr().toIpPort() << " 数据格式错误";
+        return false;
+    }
+    if (!_frames.empty()) {
+        shared_ptr<TcpConnection> self = conn->shared_from_this();
+        // 帧指向输入缓冲区，全部回调完才能retrieve
+        for (const Frame &frame : _frames) {
+            _frame(self, frame);
+        }
+    }
+    input->retrieve(used);
+    return true;
+}
+
+void EventLoop::handelWrite(int fd) {
+    TcpConnection *conn = _conns.find(fd);
+    if (conn && !conn->isDisconnected()) {
+        conn->handleWrite();
+        if (conn->readyToClose()) {
+            closeConnection(conn, fd);
+        }
+    }
+}
+
+bool EventLoop::handelError(int fd) {
+    TcpConnection *conn = _conns.find(fd);
+    if (conn && conn->isDisconnected()) {
+        // 已关闭、只等零拷贝完成通知的连接，其他事件都不再处理
+        conn->reapZeroCopy();
+        if (conn->zeroCopyPending() == 0) {
+            finishClose(conn, fd);
+        }
+        return true;
+    }
+    if (!conn || !conn->reapZeroCopy()) {
+        return false;
+    }
+    // 零拷贝完成通知也会触发EPOLLERR，只有SO_ERROR非0才是真正的错误
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    return err == 0;
+}
+
+void EventLoop::flushDirtyConnections() {
+    _flushing.swap(_dirtyConns);
+    for (const shared_ptr<TcpConnection> &conn : _flushing) {
+        conn->flush();
+        // 半关闭的连接回复发完了，关闭
+        if (!conn->isDisconnected() && conn->readyToClose()) {
+            closeConnection(conn.get(), ConnectionTable::fdOf(conn->getId()));
+        }
+    }
+    _flushing.clear();
+    // 写完成回调里又发了数据，下一轮不能阻塞在poll上
+    if (!_dirtyConns.empty()) {
+        wakeup();
+    }
+}
+
+void EventLoop::closeConnection(TcpConnection *conn, int fd) {
+    LOG_DEBUG << conn->getPeerAddr().toIpPort() << " fd=" << fd << " 断开连接";
+    conn->setDisconnected();
+    conn->closeCallback();
+    --_connCount;
+    if (conn->zeroCopyPending() > 0) {
+        // 内核确认之前，协议栈还引用着这些缓冲区的页面，提前释放会让对端收到被改写的数据
+        // fd也要保持打开才能收到完成通知：只留边缘触发的EPOLLERR，收齐后由handelError结束关闭
+        updateFd(fd, EPOLLET);
+        return;
+    }
+    if (conn->sendInFlight()) {
+        // io_uring的发送同样引用着输出数据：取消它并停止接收，由handelSent收到完成事件后结束关闭
+        _poller->cancelSend(fd);
+        updateFd(fd, EPOLLET);
+        return;
+    }
+    finishClose(conn, fd);
+}
+
+void EventLoop::finishClose(TcpConnection *conn, int fd) {
+    delFd(fd);
+    shared_ptr<TcpConnection> closed = _conns.erase(fd);
+    if (_connPool.capacity() > 0) {
+        _connPool.release(std::move(closed));
+    }
+}
+
+int EventLoop::spinPoll() {
+    auto deadline = std::chrono::steady_clock::now() + _spinBudget;
+    do {
+        int readySet = _poller->poll(_epollEvents.data(), _epollEvents.size(), 0);
+        _spinPolls.store(_spinPolls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        // 完成模式下可能只有完成事件，同样要返回，再poll会把它们清掉
+        if (readySet != 0 || completionCount() > 0) {
+            if (readySet != -1) {
+                _spinWakeups.store(_spinWakeups.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                _spinBudget = _busyPollSpin;
+            }
+            return readySet;
+        }
+    } while (std::chrono::steady_clock::now() < deadline);
+    // 自旋落空，下次少转一些
+    _spinBudget = std::max(_spinBudget / 2, _busyPollSpin / 16);
+    return 0;
 }
 
 void EventLoop::wait() {
-    int readySet = epoll_wait(_epfd, _epollEvents.data(), _epollEvents.capacity(), -1);
+    int readySet = 0;
+    bool ready = false;
+    if (_busyPollSpin > Interval::zero()) {
+        readySet = spinPoll();
+        // 完成事件在下一次poll()时才清空，只能在poll()之后立即判断
+        ready = readySet != 0 || completionCount() > 0;
+    }
+    if (!ready) {
+        readySet = _poller->poll(_epollEvents.data(), _epollEvents.size(), -1);
+        if (readySet != -1 && _busyPollSpin > Interval::zero()) {
+            _sleepWakeups.store(_sleepWakeups.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
     if (readySet == -1 && errno == EINTR) {
         return;
     } else if (readySet == -1) {
         throw "epoll出错";
     } else {
-        if ((size_t)readySet == _epollEvents.capacity()) {
-            _epollEvents.reserve(2 * _epollEvents.capacity());
-        }
-        int listenFd = _acceptor.fd();
+        auto begin = std::chrono::steady_clock::now();
+        int listenFd = _acceptor ? _acceptor->fd() : -1;
         for (int i = 0; i < readySet; ++i) {
             int fd = _epollEvents[i].data.fd;
             if (fd == listenFd) {
@@ -133,22 +574,54 @@ void EventLoop::wait() {
             } else if (fd == _eventFd) {
                 handleRead();
                 doPendingTasks();
+            } else if (fd == _timerQueue.fd()) {
+                _timerQueue.handleRead();
+            } else if (_completions) {
+                // 完成模式下连接的读由multishot recv负责，POLL_ADD只剩sendfile等待EPOLLOUT
+                // 出错时同样交给handelWrite，发送失败后不再关注EPOLLOUT
+                if (_epollEvents[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                    handelWrite(fd);
+                }
             } else {
-                handelMessage(fd);
+                uint32_t events = _epollEvents[i].events;
+                if ((events & EPOLLERR) && handelError(fd)) {
+                    events &= ~EPOLLERR;
+                }
+                if (events & EPOLLOUT) {
+                    handelWrite(fd);
+                }
+                if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                    handelMessage(fd);
+                }
             }
         }
+        if (_completions) {
+            handelCompletions();
+        }
+        flushDirtyConnections();
+        auto dispatch = std::chrono::steady_clock::now() - begin;
+        _stats.recordWakeup(readySet + (int)completionCount(),
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(dispatch).count());
+        // 数组被填满，可能还有就绪事件没取到，扩容后下一轮多取一些
+        if ((size_t)readySet == _epollEvents.size()) {
+            _epollEvents.resize(2 * _epollEvents.size());
+            _stats.recordEventsGrowth();
+        }
     }
 }
 
-void EventLoop::addFd(int fd) {
-    epoll_event event;
-    event.events = EPOLLIN;
-    event.data.fd = fd;
-    epoll_ctl(_epfd, EPOLL_CTL_ADD, fd, &event);
+void EventLoop::addFd(int fd, uint32_t events) {
+    _poller->addFd(fd, events);
+}
+
+void EventLoop::updateFd(int fd, uint32_t events) {
+    _poller->modFd(fd, events);
+}
+
+bool EventLoop::submitSend(int fd, const struct msghdr *msg) {
+    return _poller->submitSend(fd, msg);
 }
 
 void EventLoop::delFd(int fd) {
-    epoll_event event;
-    event.data.fd = fd;
-    epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, &event);
+    _poller->delFd(fd);
 }
\ No newline at end of file
@@ -1,29 +1,74 @@
 #ifndef _EVENT_LOOP_H
 #define _EVENT_LOOP_H
 
+#include "BufferSlice.h"
+#include "Codec.h"
+#include "ConnectionPool.h"
+#include "ConnectionTable.h"
+#include "LoopStats.h"
+#include "MpscQueue.h"
+#include "Poller.h"
+#include "TimerQueue.h"
+#include <atomic>
 #include <functional>
-#include <map>
 #include <memory>
-#include <mutex>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <thread>
 #include <vector>
 
+using std::atomic;
 using std::function;
-using std::map;
-using std::mutex;
 using std::shared_ptr;
+using std::unique_ptr;
 using std::vector;
 
 class Acceptor;
+class EventLoopThreadPool;
+class InetAddress;
 class TcpConnection;
 
 using functionCallback = std::function<void(const shared_ptr<TcpConnection> &)>;
+
+// 连接的回调表，每个EventLoop一份，连接只保存指向它的指针
+struct ConnectionCallbacks {
+    functionCallback newConnection;
+    functionCallback message;
+    functionCallback close;
+    functionCallback writeComplete; // 输出队列全部写入内核后调用
+    functionCallback highWaterMark; // 输出队列积压超过高水位
+    functionCallback lowWaterMark;  // 积压降到低水位以下
+};
+
+// 输出队列的水位设置，见TcpConnection::setWaterMarks
+struct WaterMarks {
+    size_t high = 0; // 0表示不限制
+    size_t low = 0;
+    bool pauseReading = true;
+};
+
 using Task = std::function<void()>;
 
+// 任务队列中的元素，记录入队时间用于统计排队延迟
+struct PendingTask {
+    Task task;
+    Timestamp queuedAt;
+};
+
+// 自旋等待的统计
+struct BusyPollStats {
+    uint64_t spinPolls = 0;    // 0超时轮询的次数
+    uint64_t spinWakeups = 0;  // 自旋期间等到事件的次数
+    uint64_t sleepWakeups = 0; // 自旋无果，阻塞等待后被唤醒的次数
+};
+
 class EventLoop {
 public:
-    EventLoop(Acceptor &acceptor, size_t maxEvents);
+    // 主Reactor：监听acceptor上的新连接
+    EventLoop(Acceptor &acceptor, size_t maxEvents, PollerType pollerType = PollerType::Epoll);
+
+    // 子Reactor：只负责已建立连接的IO
+    explicit EventLoop(size_t maxEvents, PollerType pollerType = PollerType::Epoll);
 
     ~EventLoop();
 
@@ -37,6 +82,28 @@ public:
 
     void setCloseCallback(functionCallback &&func);
 
+    void setWriteCompleteCallback(functionCallback &&func);
+
+    void setHighWaterMarkCallback(functionCallback &&func);
+
+    void setLowWaterMarkCallback(functionCallback &&func);
+
+    // 新连接使用的输出水位
+    void setWaterMarks(const WaterMarks &marks);
+
+    // 连接的输出队列有新数据，本轮事件处理完后flush，只能在EventLoop线程调用
+    void queueFlush(const shared_ptr<TcpConnection> &conn);
+
+    // 把payload发给conns中的连接，这些连接必须属于本EventLoop
+    // 可以在任意线程调用，不论多少连接都只转交一次任务，payload只增加引用计数
+    void broadcast(vector<shared_ptr<TcpConnection>> &&conns, const BufferSlice &payload);
+
+    // 把payload发给本EventLoop上的所有连接，可以在任意线程调用
+    void broadcastAll(const BufferSlice &payload);
+
+    // 设置后不再调用消息回调，而是由codec切出完整的帧，逐帧调用frameCallback
+    void setCodec(const shared_ptr<Codec> &codec, FrameCallback &&frameCallback);
+
     // 创建用于通知的文件描述符
     int createEventFd();
 
@@ -49,33 +116,162 @@ public:
     // 执行任务，将数据发给客户端
     void doPendingTasks();
 
-    // 存放任务到vector中，并且唤醒Reactor/EventLoop
+    // 在EventLoop线程中调用时直接执行，否则存放到任务队列中，并且唤醒Reactor/EventLoop
     void runInLoop(Task &&task);
 
+    // 总是存放到任务队列中，留到本轮事件处理完后执行
+    void queueInLoop(Task &&task);
+
+    bool isInLoopThread();
+
+    // 修改fd关注的事件，只能在本EventLoop线程调用
+    void updateFd(int fd, uint32_t events);
+
+    // io_uring完成模式下提交连接的发送，见Poller::submitSend，只能在本EventLoop线程调用
+    bool submitSend(int fd, const struct msghdr *msg);
+
+    // 设置子Reactor集合后，主Reactor只负责accept，连接交给子Reactor
+    void setThreadPool(EventLoopThreadPool *pool);
+
+    // 把已accept的连接交给本EventLoop，可以在其他线程调用
+    void queueConnection(int fd, const InetAddress &peer);
+
+    // 本EventLoop当前负责的连接数
+    size_t connectionCount();
+
+    // 开启后连接以EPOLLET注册且设为非阻塞，默认水平触发
+    void setEdgeTriggered(bool on);
+
+    // 按编号查找本EventLoop中的连接，只能在本EventLoop线程调用
+    shared_ptr<TcpConnection> findConnection(ConnId id);
+
+    // 定时器，回调在本EventLoop线程中执行，可以在任意线程调用
+    // 在when时刻执行一次
+    TimerId runAt(Timestamp when, TimerCallback &&cb);
+
+    // delay之后执行一次
+    TimerId runAfter(Interval delay, TimerCallback &&cb);
+
+    // 每隔interval执行一次，直到被取消
+    TimerId runEvery(Interval interval, TimerCallback &&cb);
+
+    void cancel(TimerId id);
+
+    // 自旋等待：阻塞在epoll_wait之前，先以0超时轮询最多spin时长，用CPU换取更低的唤醒延迟
+    // 自旋连续落空时预算减半，等到事件时恢复，最低为spin的1/16；spin为0表示关闭
+    // sockBusyPollUs大于0时对新连接设置SO_BUSY_POLL(通常需要CAP_NET_ADMIN)
+    void setBusyPoll(Interval spin, int sockBusyPollUs = 0);
+
+    // 回收已关闭的连接对象，最多缓存capacity个，0表示不回收
+    // 每隔trimInterval检查一次，期间没有新连接时释放一半空闲对象
+    void setConnectionPool(size_t capacity, Interval trimInterval = std::chrono::seconds(1));
+
+    // 新连接开启MSG_ZEROCOPY，不小于threshold字节的消息零拷贝发送，0表示关闭
+    // io_uring完成模式下发送由io_uring完成，忽略此设置
+    void setZeroCopy(size_t threshold);
+
+    // 新连接每次读到数据后设置TCP_QUICKACK，见SocketOptions::quickAck
+    void setQuickAck(bool on);
+
+    // 可以在任意线程调用
+    BusyPollStats getBusyPollStats();
+
+    // 运行统计的快照，可以在任意线程调用
+    LoopStatsSnapshot getStats();
+
 private:
-    int _epfd;
-    bool _isLooping;
-    mutex _mutex;
-    Acceptor &_acceptor;
+    unique_ptr<Poller> _poller;
+    const vector<Completion> *_completions; // io_uring完成模式下的完成事件，其他情况为nullptr
+    atomic<bool> _isLooping;
+    atomic<std::thread::id> _threadId;
+    Acceptor *_acceptor;
+    EventLoopThreadPool *_threadPool;
+    atomic<size_t> _connCount;
+    bool _edgeTriggered;
+    TimerQueue _timerQueue;
+    atomic<TimerId> _nextTimerId;
+    Interval _busyPollSpin;
+    Interval _spinBudget;
+    int _sockBusyPollUs;
+    size_t _zeroCopyThreshold;
+    bool _quickAck;
+    atomic<uint64_t> _spinPolls;
+    atomic<uint64_t> _spinWakeups;
+    atomic<uint64_t> _sleepWakeups;
+    LoopStats _stats;
     int _eventFd;
     vector<struct epoll_event> _epollEvents;
-    vector<Task> _pendings;
-    map<int, shared_ptr<TcpConnection>> _conns;
-    functionCallback _newConnection;
-    functionCallback _message;
-    functionCallback _close;
-
-    int createEpoll();
+    MpscQueue<PendingTask> _pendings;
+    atomic<bool> _wakeupPending; // 已写过eventfd但还未被处理，期间不必重复唤醒
+    ConnectionTable _conns;
+    ConnectionPool _connPool;
+    ConnectionCallbacks _callbacks;
+    WaterMarks _waterMarks;
+    shared_ptr<Codec> _codec;
+    FrameCallback _frame;
+    vector<Frame> _frames; // 解码用的临时数组，跨调用复用
+    vector<shared_ptr<TcpConnection>> _dirtyConns; // 本轮有新输出的连接
+    vector<shared_ptr<TcpConnection>> _flushing;
 
     void wait();
 
-    void addFd(int fd);
+    // 在自旋预算内以0超时轮询，返回就绪事件数，预算用完仍无事件时返回0
+    int spinPoll();
+
+    void addFd(int fd, uint32_t events = EPOLLIN);
 
     void delFd(int fd);
 
     void handelNewConnection();
 
+    // 主Reactor把连接交给子Reactor，否则在本EventLoop建立
+    void dispatchConnection(int connFd, const InetAddress &peer);
+
+    // 在本EventLoop中为fd创建TcpConnection
+    void establishConnection(int fd, const InetAddress &peer);
+
     void handelMessage(int fd);
+
+    // 读到数据(或EOF)之后：调用消息回调或解码，处理对端关闭
+    void handelInput(TcpConnection *conn, int fd, int bytes);
+
+    // 上一次poll()得到的完成事件数
+    size_t completionCount();
+
+    // 完成模式：处理multishot accept/recv和发送的结果
+    void handelCompletions();
+
+    void handelAccepted(int connFd);
+
+    void handelReceived(int fd, const char *data, int len);
+
+    void handelSent(int fd, int res);
+
+    // 用codec解码输入缓冲区并逐帧回调，数据不合法时返回false
+    bool handelFrames(TcpConnection *conn);
+
+    void sendToConnections(vector<shared_ptr<TcpConnection>> &conns, const BufferSlice &payload);
+
+    void sendToAll(const BufferSlice &payload);
+
+    // 每轮事件处理的最后，把各连接这一轮积攒的输出一次写出
+    void flushDirtyConnections();
+
+    // 连接可写，继续发送输出缓冲区
+    void handelWrite(int fd);
+
+    // EPOLLERR：先取零拷贝完成通知，全部是完成通知时返回true
+    bool handelError(int fd);
+
+    // 关闭连接：调用关闭回调，没有未确认的零拷贝发送和进行中的io_uring发送时立即从epoll和连接表中移除
+    void closeConnection(TcpConnection *conn, int fd);
+
+    // 从epoll和连接表中移除，交给连接池
+    // 还有零拷贝发送没确认时closeConnection先不调用它，等handelError收齐完成通知；
+    // io_uring发送还没完成时同样要等，由handelSent结束关闭
+    void finishClose(TcpConnection *conn, int fd);
+
+    TimerId addTimer(Timestamp when, Interval interval, TimerCallback &&cb);
 };
 
 #endif
\ No newline at end of file
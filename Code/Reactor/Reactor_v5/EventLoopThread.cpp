@@ -0,0 +1,47 @@
+#include "EventLoopThread.h"
+#include <pthread.h>
+
+EventLoopThread::EventLoopThread(size_t maxEvents, PollerType pollerType) : _loop(maxEvents, pollerType), _cpu(-1) {}
+
+EventLoopThread::EventLoopThread(const InetAddress &addr, int backlog, const SocketOptions &opts, size_t maxEvents,
+                                 PollerType pollerType)
+    : _acceptor(new Acceptor(addr, backlog)), _loop(*_acceptor, maxEvents, pollerType), _cpu(-1) {
+    _acceptor->setSocketOptions(opts);
+}
+
+EventLoopThread::~EventLoopThread() {
+    stop();
+}
+
+EventLoop *EventLoopThread::start() {
+    if (_acceptor) {
+        _acceptor->ready();
+    }
+    _thread = thread{&EventLoop::loop, &_loop};
+    if (_cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(_cpu, &cpus);
+        pthread_setaffinity_np(_thread.native_handle(), sizeof(cpus), &cpus);
+    }
+    return &_loop;
+}
+
+void EventLoopThread::stop() {
+    if (_thread.joinable()) {
+        _loop.unLoop();
+        _thread.join();
+    }
+}
+
+EventLoop *EventLoopThread::getLoop() {
+    return &_loop;
+}
+
+void EventLoopThread::setCpu(int cpu) {
+    _cpu = cpu;
+}
+
+int EventLoopThread::getCpu() {
+    return _cpu;
+}
@@ -0,0 +1,46 @@
+#ifndef _EVENT_LOOP_THREAD_H
+#define _EVENT_LOOP_THREAD_H
+
+#include "Acceptor.h"
+#include "EventLoop.h"
+#include <memory>
+#include <thread>
+
+using std::thread;
+using std::unique_ptr;
+
+// 一个子Reactor：拥有自己的EventLoop，并在独立线程中运行loop()
+class EventLoopThread {
+public:
+    explicit EventLoopThread(size_t maxEvents, PollerType pollerType = PollerType::Epoll);
+
+    // SO_REUSEPORT分片：本线程拥有自己的监听套接字，独立accept并处理自己的连接
+    EventLoopThread(const InetAddress &addr, int backlog, const SocketOptions &opts, size_t maxEvents,
+                    PollerType pollerType = PollerType::Epoll);
+
+    ~EventLoopThread();
+
+    // 启动线程，返回该线程所拥有的EventLoop
+    EventLoop *start();
+
+    void stop();
+
+    EventLoop *getLoop();
+
+    // 在start()之前调用，把线程绑定到指定CPU，-1表示不绑定
+    void setCpu(int cpu);
+
+    int getCpu();
+
+private:
+    unique_ptr<Acceptor> _acceptor; // 分片模式才有，必须在_loop之前构造
+    EventLoop _loop;
+    int _cpu;
+    thread _thread;
+
+    EventLoopThread(const EventLoopThread &) = delete;
+
+    EventLoopThread &operator=(const EventLoopThread &) = delete;
+};
+
+#endif
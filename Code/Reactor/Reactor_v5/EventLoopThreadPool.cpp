@@ -0,0 +1,75 @@
+#include "EventLoopThreadPool.h"
+
+EventLoopThreadPool::EventLoopThreadPool(size_t threadNum, size_t maxEvents, PollerType pollerType)
+    : _next(0), _strategy(LoadBalance::RoundRobin), _maxEvents(maxEvents), _pollerType(pollerType) {
+    for (size_t i = 0; i < threadNum; ++i) {
+        _threads.push_back(unique_ptr<EventLoopThread>(new EventLoopThread(maxEvents, pollerType)));
+    }
+}
+
+void EventLoopThreadPool::start() {
+    for (auto &th : _threads) {
+        th->start();
+    }
+}
+
+void EventLoopThreadPool::stop() {
+    for (auto &th : _threads) {
+        th->stop();
+    }
+}
+
+void EventLoopThreadPool::setLoadBalance(LoadBalance strategy) {
+    _strategy = strategy;
+}
+
+void EventLoopThreadPool::setReusePort(const InetAddress &addr, int backlog, const SocketOptions &opts, bool pinCpu) {
+    size_t threadNum = _threads.size();
+    unsigned cpuNum = std::thread::hardware_concurrency();
+    _threads.clear();
+    for (size_t i = 0; i < threadNum; ++i) {
+        _threads.push_back(unique_ptr<EventLoopThread>(new EventLoopThread(addr, backlog, opts, _maxEvents, _pollerType)));
+        if (pinCpu && cpuNum > 0) {
+            _threads.back()->setCpu(i % cpuNum);
+        }
+    }
+}
+
+EventLoop *EventLoopThreadPool::getNextLoop() {
+    if (_threads.empty()) {
+        return nullptr;
+    }
+    if (_strategy == LoadBalance::LeastConnections) {
+        EventLoop *best = _threads[0]->getLoop();
+        for (size_t i = 1; i < _threads.size(); ++i) {
+            EventLoop *loop = _threads[i]->getLoop();
+            if (loop->connectionCount() < best->connectionCount()) {
+                best = loop;
+            }
+        }
+        return best;
+    }
+    EventLoop *loop = _threads[_next]->getLoop();
+    _next = (_next + 1) % _threads.size();
+    return loop;
+}
+
+vector<EventLoop *> EventLoopThreadPool::getAllLoops() {
+    vector<EventLoop *> loops;
+    for (auto &th : _threads) {
+        loops.push_back(th->getLoop());
+    }
+    return loops;
+}
+
+vector<int> EventLoopThreadPool::getCpus() {
+    vector<int> cpus;
+    for (auto &th : _threads) {
+        cpus.push_back(th->getCpu());
+    }
+    return cpus;
+}
+
+size_t EventLoopThreadPool::size() {
+    return _threads.size();
+}
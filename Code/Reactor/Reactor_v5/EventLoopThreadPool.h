@@ -0,0 +1,50 @@
+#ifndef _EVENT_LOOP_THREAD_POOL_H
+#define _EVENT_LOOP_THREAD_POOL_H
+
+#include "EventLoopThread.h"
+#include <memory>
+#include <vector>
+
+using std::unique_ptr;
+using std::vector;
+
+// 新连接分发给子Reactor的策略
+enum class LoadBalance {
+    RoundRobin,      // 轮询
+    LeastConnections // 当前连接数最少
+};
+
+// 多Reactor模式下的子Reactor集合，每个子Reactor一个IO线程
+class EventLoopThreadPool {
+public:
+    EventLoopThreadPool(size_t threadNum, size_t maxEvents, PollerType pollerType = PollerType::Epoll);
+
+    void start();
+
+    void stop();
+
+    void setLoadBalance(LoadBalance strategy);
+
+    // 在start()之前调用：每个子Reactor各自监听addr(SO_REUSEPORT)，由内核分配新连接
+    // pinCpu为true时第i个线程绑定到第i个CPU
+    void setReusePort(const InetAddress &addr, int backlog, const SocketOptions &opts, bool pinCpu);
+
+    // 为新连接挑选一个子Reactor，没有子Reactor时返回nullptr
+    EventLoop *getNextLoop();
+
+    vector<EventLoop *> getAllLoops();
+
+    // 各线程绑定的CPU，顺序同getAllLoops，-1表示没有绑定
+    vector<int> getCpus();
+
+    size_t size();
+
+private:
+    vector<unique_ptr<EventLoopThread>> _threads;
+    size_t _next;
+    LoadBalance _strategy;
+    size_t _maxEvents;
+    PollerType _pollerType;
+};
+
+#endif
@@ -1,26 +1,37 @@
 #include "HeadServer.h"
+#include "Logger.h"
 #include "TcpConnection.h"
 
-MyTask::MyTask(const string &msg, const shared_ptr<TcpConnection> &conn)
-    : _msg(msg), _conn(conn) {}
+MyTask::MyTask(string &&msg, const shared_ptr<TcpConnection> &conn, const Codec *codec)
+    : _msg(std::move(msg)), _conn(conn), _codec(codec) {}
 
 // 处理数据
 void MyTask::process() {
     // 在这里处理数据
     // 处理(_msg);
     // 处理完毕
-    _conn->sendInLoop(_msg);
+    _conn->replyInLoop(_codec->encode(_msg));
 }
 
-HeadServer::HeadServer(size_t threadNum, size_t queueSize, const string &ip, unsigned short port, size_t maxEvents)
-    : _pool(threadNum, queueSize), _tcpSvr(ip, port, maxEvents) {}
+HeadServer::HeadServer(size_t threadNum, size_t queueSize, const string &ip, unsigned short port, size_t maxEvents,
+                       size_t ioThreadNum, PollerType pollerType, const SocketOptions &sockOpts)
+    : HeadServer(threadNum, queueSize, InetAddress(ip, port), maxEvents, ioThreadNum, pollerType, sockOpts) {}
+
+HeadServer::HeadServer(size_t threadNum, size_t queueSize, const InetAddress &listenAddr, size_t maxEvents,
+                       size_t ioThreadNum, PollerType pollerType, const SocketOptions &sockOpts)
+    : _pool(threadNum, queueSize), _tcpSvr(listenAddr, maxEvents, ioThreadNum, pollerType, sockOpts), _codec(new LineCodec()) {
+    _pool.setLowWaterCallback(queueSize / 2, std::bind(&HeadServer::drainBacklog, this));
+    // 慢速客户端最多积压4MB回复，超过后暂停读取它的请求
+    _tcpSvr.setWaterMarks(4 * 1024 * 1024, 1024 * 1024);
+}
 
 void HeadServer::start() {
     _pool.start();
     using namespace std::placeholders;
     _tcpSvr.setAllCallback(std::bind(&HeadServer::newConnection, this, _1),
-                           std::bind(&HeadServer::message, this, _1),
+                           functionCallback(),
                            std::bind(&HeadServer::closeConnection, this, _1));
+    _tcpSvr.setCodec(_codec, std::bind(&HeadServer::message, this, _1, _2));
     _tcpSvr.start();
 }
 
@@ -29,22 +40,76 @@ void HeadServer::stop() {
     _tcpSvr.stop();
 }
 
+void HeadServer::setEdgeTriggered(bool on) {
+    _tcpSvr.setEdgeTriggered(on);
+}
+
+void HeadServer::setBusyPoll(Interval spin, int sockBusyPollUs) {
+    _tcpSvr.setBusyPoll(spin, sockBusyPollUs);
+}
+
+void HeadServer::setReusePortShards(bool on, bool cpuSteering) {
+    _tcpSvr.setReusePortShards(on, cpuSteering);
+}
+
+void HeadServer::setConnectionPool(size_t capacity, Interval trimInterval) {
+    _tcpSvr.setConnectionPool(capacity, trimInterval);
+}
+
+void HeadServer::setWaterMarks(size_t high, size_t low, bool pauseReading) {
+    _tcpSvr.setWaterMarks(high, low, pauseReading);
+}
+
+void HeadServer::setZeroCopy(size_t threshold) {
+    _tcpSvr.setZeroCopy(threshold);
+}
+
 void HeadServer::newConnection(const shared_ptr<TcpConnection> &conn) {
-    cout << "新连接到来时, main定义的函数回调" << endl;
+    LOG_DEBUG << "新连接到来时, main定义的函数回调";
 }
 
-void HeadServer::message(const shared_ptr<TcpConnection> &conn) {
-    string str = conn->receive();
-    if (str.size() != 0) {
-        cout << "收到：" << str << endl;
-    }
+void HeadServer::message(const shared_ptr<TcpConnection> &conn, const Frame &frame) {
+    // 每条消息一行，默认级别下不格式化
+    LOG_DEBUG << "收到：" << LogData(frame.data, frame.len);
     // 这里收到信息，创建任务将其加入任务队列异步执行
     // 执行完毕后会自动调用sendInLoop创建新的返回任务
     // 异步回复给客户端
-    MyTask task{msg, conn};
-    _pool.addTask(std::bind(&MyTask::process, task));
+    // 帧只在回调期间有效，retain()是交给线程池前唯一的一次拷贝
+    // 对端发完请求就半关闭时，连接要等这条回复发出后再关闭
+    conn->expectReply();
+    MyTask task{frame.retain(), conn, _codec.get()};
+    Task job = std::bind(&MyTask::process, std::move(task));
+    std::lock_guard<std::mutex> lock(_backlogMutex);
+    // 已有积压时也排到后面，保持先后顺序
+    if (_backlog.empty() && _pool.tryAddTask(std::move(job))) {
+        return;
+    }
+    // 线程池处理不过来：不再阻塞IO线程，暂停读取这个连接，等线程池队列降到低水位再恢复
+    _backlog.push_back(std::move(job));
+    if (_pausedConns.empty() || _pausedConns.back() != conn) {
+        conn->pauseReading();
+        _pausedConns.push_back(conn);
+    }
+}
+
+void HeadServer::drainBacklog() {
+    std::vector<shared_ptr<TcpConnection>> paused;
+    {
+        std::lock_guard<std::mutex> lock(_backlogMutex);
+        while (!_backlog.empty()) {
+            // 又满了：tryAddTask已经记下饱和，之后还会再回调
+            if (!_pool.tryAddTask(std::move(_backlog.front()))) {
+                return;
+            }
+            _backlog.pop_front();
+        }
+        paused.swap(_pausedConns);
+    }
+    for (const shared_ptr<TcpConnection> &conn : paused) {
+        conn->resumeReadingInLoop();
+    }
 }
 
 void HeadServer::closeConnection(const shared_ptr<TcpConnection> &conn) {
-    cout << "回调函数：对方关闭连接" << endl;
+    LOG_DEBUG << "回调函数：对方关闭连接";
 }
\ No newline at end of file
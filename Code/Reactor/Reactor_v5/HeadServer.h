@@ -1,10 +1,14 @@
 #ifndef _HEAD_SERVER_H
 #define _HEAD_SERVER_H
 
+#include "Codec.h"
 #include "TcpServer.h"
 #include "ThreadPool.h"
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 using std::shared_ptr;
 using std::string;
@@ -13,7 +17,8 @@ class TcpConnection;
 
 class MyTask {
 public:
-    MyTask(const string &msg, const shared_ptr<TcpConnection> &conn);
+    // msg由帧retain()得到，直接移动进来，codec用于编码回复
+    MyTask(string &&msg, const shared_ptr<TcpConnection> &conn, const Codec *codec);
 
     // 处理数据
     void process();
@@ -21,27 +26,66 @@ public:
 private:
     string _msg;
     shared_ptr<TcpConnection> _conn;
+    const Codec *_codec;
 };
 
 class HeadServer {
 public:
-    HeadServer(size_t threadNum, size_t queueSize, const string &ip, unsigned short port, size_t maxEvents);
+    // ioThreadNum：子Reactor(IO线程)的数量，0表示单Reactor
+    // pollerType：IO多路复用后端，默认epoll
+    // sockOpts：监听套接字和新连接的选项，见SocketOptions
+    HeadServer(size_t threadNum, size_t queueSize, const string &ip, unsigned short port, size_t maxEvents,
+               size_t ioThreadNum = 0, PollerType pollerType = PollerType::Epoll,
+               const SocketOptions &sockOpts = SocketOptions());
+
+    // 监听IPv6或Unix域地址，见TcpServer
+    HeadServer(size_t threadNum, size_t queueSize, const InetAddress &listenAddr, size_t maxEvents,
+               size_t ioThreadNum = 0, PollerType pollerType = PollerType::Epoll,
+               const SocketOptions &sockOpts = SocketOptions());
 
     // 服务器的启动与停止
     void start();
 
     void stop();
 
+    // 在start()之前调用，开启边缘触发+非阻塞IO
+    void setEdgeTriggered(bool on);
+
+    // 在start()之前调用，开启自旋等待，见EventLoop::setBusyPoll
+    void setBusyPoll(Interval spin, int sockBusyPollUs = 0);
+
+    // 在start()之前调用，开启SO_REUSEPORT分片，见TcpServer::setReusePortShards
+    void setReusePortShards(bool on, bool cpuSteering = false);
+
+    // 在start()之前调用，回收已关闭的连接对象，见EventLoop::setConnectionPool
+    void setConnectionPool(size_t capacity, Interval trimInterval = std::chrono::seconds(1));
+
+    // 在start()之前调用，输出队列的水位，见TcpServer::setWaterMarks
+    void setWaterMarks(size_t high, size_t low, bool pauseReading = true);
+
+    // 在start()之前调用，大回复使用MSG_ZEROCOPY，见TcpServer::setZeroCopy
+    void setZeroCopy(size_t threshold);
+
     // 三个回调
     void newConnection(const shared_ptr<TcpConnection> &conn);
 
-    void message(const shared_ptr<TcpConnection> &conn);
+    // 每收到一行调用一次
+    void message(const shared_ptr<TcpConnection> &conn, const Frame &frame);
 
     void closeConnection(const shared_ptr<TcpConnection> &conn);
 
 private:
-    ThreadPool _pool;  // 线程池子对象
-    TcpServer _tcpSvr; // TcpServer子对象
+    ThreadPool _pool;          // 线程池子对象
+    TcpServer _tcpSvr;         // TcpServer子对象
+    shared_ptr<Codec> _codec;  // 按行切分消息
+
+    // 线程池队列满时，任务先放在这里，对应的连接暂停读取
+    std::mutex _backlogMutex;
+    std::deque<Task> _backlog;
+    std::vector<shared_ptr<TcpConnection>> _pausedConns;
+
+    // 线程池队列降到低水位时在工作线程中调用：把积压的任务放进线程池，全部放完后恢复读取
+    void drainBacklog();
 };
 
 #endif
\ No newline at end of file
@@ -1,25 +1,127 @@
 #include "InetAddress.h"
+#include <algorithm>
+#include <stddef.h>
+#include <string.h>
+
+InetAddress::InetAddress() : _len(sizeof(struct sockaddr_in)) {
+    memset(&_addr, 0, sizeof(_addr));
+    _addr._v4.sin_family = AF_INET;
+}
 
 InetAddress::InetAddress(const string &ip, unsigned short port) {
-    _addr.sin_family = AF_INET;
-    _addr.sin_addr.s_addr = inet_addr(ip.c_str());
-    _addr.sin_port = htons(port);
+    memset(&_addr, 0, sizeof(_addr));
+    if (ip.find(':') != string::npos) {
+        _addr._v6.sin6_family = AF_INET6;
+        _addr._v6.sin6_port = htons(port);
+        if (inet_pton(AF_INET6, ip.c_str(), &_addr._v6.sin6_addr) != 1) {
+            throw "IPv6地址格式错误";
+        }
+        _len = sizeof(struct sockaddr_in6);
+    } else {
+        _addr._v4.sin_family = AF_INET;
+        _addr._v4.sin_addr.s_addr = inet_addr(ip.c_str());
+        _addr._v4.sin_port = htons(port);
+        _len = sizeof(struct sockaddr_in);
+    }
+}
+
+InetAddress::InetAddress(const struct sockaddr_in &addr) : _len(sizeof(struct sockaddr_in)) {
+    memset(&_addr, 0, sizeof(_addr));
+    _addr._v4.sin_family = AF_INET;
+    _addr._v4.sin_addr.s_addr = addr.sin_addr.s_addr;
+    _addr._v4.sin_port = addr.sin_port;
+}
+
+InetAddress::InetAddress(const struct sockaddr *addr, socklen_t len) : _len(len) {
+    memset(&_addr, 0, sizeof(_addr));
+    _addr._sa.sa_family = addr->sa_family;
+    if (addr->sa_family == AF_UNIX) {
+        // 客户端通常不bind，accept得到的是未命名地址，只有地址族，不用分配
+        if (len <= offsetof(struct sockaddr_un, sun_path)) {
+            return;
+        }
+        _unix = std::make_shared<struct sockaddr_un>();
+        memset(_unix.get(), 0, sizeof(struct sockaddr_un));
+        memcpy(_unix.get(), addr, std::min<size_t>(len, sizeof(struct sockaddr_un)));
+    } else {
+        memcpy(&_addr, addr, std::min<size_t>(len, sizeof(_addr)));
+    }
+}
+
+InetAddress InetAddress::unixPath(const string &path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        throw "Unix域套接字路径长度错误";
+    }
+    // 抽象命名空间：sun_path[0]为'\0'，名字不以'\0'结尾，长度由socklen_t决定
+    memcpy(addr.sun_path, path.data(), path.size());
+    socklen_t len = offsetof(struct sockaddr_un, sun_path) + path.size();
+    if (path[0] == '@') {
+        addr.sun_path[0] = '\0';
+    } else {
+        ++len; // 带上结尾的'\0'
+    }
+    return InetAddress((struct sockaddr *)&addr, len);
 }
 
-InetAddress::InetAddress(const struct sockaddr_in &addr) {
-    _addr.sin_family = AF_INET;
-    _addr.sin_addr.s_addr = addr.sin_addr.s_addr;
-    _addr.sin_port = addr.sin_port;
+sa_family_t InetAddress::family() const {
+    return _addr._sa.sa_family;
 }
 
 string InetAddress::getIp() {
-    return string(inet_ntoa(_addr.sin_addr));
+    char buf[INET6_ADDRSTRLEN];
+    switch (family()) {
+    case AF_INET:
+        return string(inet_ntop(AF_INET, &_addr._v4.sin_addr, buf, sizeof(buf)));
+    case AF_INET6:
+        return string(inet_ntop(AF_INET6, &_addr._v6.sin6_addr, buf, sizeof(buf)));
+    case AF_UNIX: {
+        size_t pathLen = _len > offsetof(struct sockaddr_un, sun_path) ? _len - offsetof(struct sockaddr_un, sun_path) : 0;
+        if (pathLen == 0) {
+            return string();
+        }
+        if (_unix->sun_path[0] == '\0') {
+            return "@" + string(_unix->sun_path + 1, pathLen - 1);
+        }
+        return string(_unix->sun_path, strnlen(_unix->sun_path, pathLen));
+    }
+    default:
+        return string();
+    }
 }
 
 unsigned short InetAddress::getPort() {
-    return ntohs(_addr.sin_port);
+    switch (family()) {
+    case AF_INET:
+        return ntohs(_addr._v4.sin_port);
+    case AF_INET6:
+        return ntohs(_addr._v6.sin6_port);
+    default:
+        return 0;
+    }
 }
 
-struct sockaddr_in *InetAddress::getInetAddressPtr() {
-    return &_addr;
-}
\ No newline at end of file
+string InetAddress::toIpPort() {
+    switch (family()) {
+    case AF_INET:
+        return getIp() + ":" + std::to_string(getPort());
+    case AF_INET6:
+        return "[" + getIp() + "]:" + std::to_string(getPort());
+    default:
+        return getIp();
+    }
+}
+
+const struct sockaddr *InetAddress::getSockAddr() const {
+    return _unix ? (const struct sockaddr *)_unix.get() : &_addr._sa;
+}
+
+socklen_t InetAddress::getSockLen() const {
+    return _len;
+}
+
+bool InetAddress::isUnixPathname() const {
+    return family() == AF_UNIX && _len > offsetof(struct sockaddr_un, sun_path) && _unix->sun_path[0] != '\0';
+}
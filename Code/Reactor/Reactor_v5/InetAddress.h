@@ -2,25 +2,59 @@
 #define _INETADDRESS_H
 
 #include <arpa/inet.h>
+#include <memory>
 #include <netinet/in.h>
 #include <string>
+#include <sys/un.h>
 
+using std::shared_ptr;
 using std::string;
 
+// 套接字地址：IPv4、IPv6或Unix域(AF_UNIX)
+// IPv4/IPv6直接保存在对象里；sockaddr_un有110字节，只有Unix域地址才单独分配，
+// 避免每个连接的对端地址都按最大的地址族占用内存
 class InetAddress {
 public:
+    // IPv4的0.0.0.0:0
+    InetAddress();
+
+    // ip中含':'时为IPv6地址，"::"监听时同时接受IPv4连接(双栈)
     InetAddress(const string &ip, unsigned short port);
 
     InetAddress(const struct sockaddr_in &addr);
 
+    // accept/getsockname得到的任意地址族的地址
+    InetAddress(const struct sockaddr *addr, socklen_t len);
+
+    // Unix域地址，path以'@'开头时为Linux抽象命名空间(不在文件系统中创建文件)
+    static InetAddress unixPath(const string &path);
+
+    sa_family_t family() const;
+
+    // IPv4/IPv6为点分/冒号格式的地址，Unix域为路径(抽象命名空间以'@'开头)，未命名的Unix域套接字为空串
     string getIp();
 
+    // Unix域为0
     unsigned short getPort();
 
-    struct sockaddr_in *getInetAddressPtr();
+    // "ip:port"，IPv6为"[ip]:port"，Unix域为路径
+    string toIpPort();
+
+    const struct sockaddr *getSockAddr() const;
+
+    socklen_t getSockLen() const;
+
+    // 文件系统中的Unix域路径，bind之前需要先unlink；其他情况返回false
+    bool isUnixPathname() const;
 
 private:
-    struct sockaddr_in _addr;
+    union {
+        struct sockaddr _sa;
+        struct sockaddr_in _v4;
+        struct sockaddr_in6 _v6;
+    } _addr;
+    socklen_t _len;
+    shared_ptr<struct sockaddr_un> _unix; // 有路径的AF_UNIX地址才分配，复制地址只增加引用计数
 };
 
-#endif //_INETADDRESS_H
\ No newline at end of file
+#endif //_INETADDRESS_H
@@ -0,0 +1,561 @@
+#include "IoUringPoller.h"
+#include "Logger.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+// POLL_REMOVE/ASYNC_CANCEL请求本身的user_data，它们的完成事件直接忽略
+const uint64_t kRemoveTag = ~0ULL;
+
+// user_data：高32位为序号，第28~31位为操作，低28位为fd
+const unsigned kOpPoll = 0;
+const unsigned kOpAccept = 1;
+const unsigned kOpRecv = 2;
+const unsigned kOpSend = 3;
+const uint64_t kFdMask = (1u << 28) - 1;
+
+// 每个EventLoop一个buffer ring，共kRecvBufCount * kRecvBufSize = 4MB
+const unsigned kRecvBufCount = 1024; // 必须是2的幂
+const unsigned kRecvBufSize = 4096;
+const uint16_t kBufGroup = 0;
+
+int ioUringSetup(unsigned entries, struct io_uring_params *params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, void *arg, size_t argSize) {
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize);
+}
+
+int ioUringRegister(int fd, unsigned opcode, void *arg, unsigned nrArgs) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs);
+}
+
+} // namespace
+
+IoUringPoller::IoUringPoller(unsigned entries)
+    : _ringFd(-1), _hasExtArg(false), _multishot(true), _completion(false),
+      _sqRing(MAP_FAILED), _sqRingSize(0), _cqRing(MAP_FAILED), _cqRingSize(0),
+      _sqes(static_cast<struct io_uring_sqe *>(MAP_FAILED)), _sqesSize(0),
+      _sqHead(nullptr), _sqTail(nullptr), _sqMask(0), _sqEntries(0), _sqArray(nullptr),
+      _sqLocalTail(0), _toSubmit(0),
+      _cqHead(nullptr), _cqTail(nullptr), _cqMask(0), _cqes(nullptr),
+      _nextSeq(0), _bufRing(nullptr), _recvBufs(nullptr) {
+    if (!setup(entries) && _ringFd >= 0) {
+        close(_ringFd);
+        _ringFd = -1;
+    }
+    if (_ringFd >= 0) {
+        _completion = setupCompletion();
+    }
+}
+
+IoUringPoller::~IoUringPoller() {
+    if (_sqes != MAP_FAILED) {
+        munmap(_sqes, _sqesSize);
+    }
+    if (_cqRing != MAP_FAILED && _cqRing != _sqRing) {
+        munmap(_cqRing, _cqRingSize);
+    }
+    if (_sqRing != MAP_FAILED) {
+        munmap(_sqRing, _sqRingSize);
+    }
+    if (_ringFd >= 0) {
+        close(_ringFd);
+    }
+    // 关闭ring之后内核不再往缓冲区里写
+    if (_bufRing) {
+        munmap(_bufRing, kRecvBufCount * sizeof(struct io_uring_buf));
+    }
+    if (_recvBufs) {
+        munmap(_recvBufs, (size_t)kRecvBufCount * kRecvBufSize);
+    }
+}
+
+bool IoUringPoller::setup(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    _ringFd = ioUringSetup(entries, &params);
+    if (_ringFd < 0) {
+        LOG_WARN << "io_uring_setup: " << strerror(errno);
+        return false;
+    }
+    // 只支持单次mmap同时映射SQ和CQ的内核(5.4+)
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        return false;
+    }
+    _hasExtArg = params.features & IORING_FEAT_EXT_ARG;
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (_cqRingSize > _sqRingSize) {
+        _sqRingSize = _cqRingSize;
+    }
+    _sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+    if (_sqRing == MAP_FAILED) {
+        LOG_ERROR << "mmap sq ring: " << strerror(errno);
+        return false;
+    }
+    _cqRing = _sqRing;
+    _sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    _sqes = static_cast<struct io_uring_sqe *>(
+        mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES));
+    if (_sqes == MAP_FAILED) {
+        LOG_ERROR << "mmap sqes: " << strerror(errno);
+        return false;
+    }
+
+    char *sq = static_cast<char *>(_sqRing);
+    _sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    _sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    _sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    _sqEntries = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_entries);
+    _sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    _sqLocalTail = *_sqTail;
+
+    char *cq = static_cast<char *>(_cqRing);
+    _cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    _cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    _cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+}
+
+bool IoUringPoller::setupCompletion() {
+    // multishot recv和IORING_OP_SEND_ZC都是6.0加入的，用后者判断内核版本
+    vector<char> probeMem(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op), 0);
+    struct io_uring_probe *probe = reinterpret_cast<struct io_uring_probe *>(probeMem.data());
+    if (ioUringRegister(_ringFd, IORING_REGISTER_PROBE, probe, 256) < 0 || probe->last_op < IORING_OP_SEND_ZC ||
+        !(probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED)) {
+        LOG_INFO << "内核不支持multishot recv，io_uring只做就绪通知";
+        return false;
+    }
+    size_t ringSize = kRecvBufCount * sizeof(struct io_uring_buf);
+    void *ring = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        LOG_ERROR << "mmap buf ring: " << strerror(errno);
+        return false;
+    }
+    size_t bufsSize = (size_t)kRecvBufCount * kRecvBufSize;
+    void *bufs = mmap(nullptr, bufsSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufs == MAP_FAILED) {
+        LOG_ERROR << "mmap recv buffers: " << strerror(errno);
+        munmap(ring, ringSize);
+        return false;
+    }
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring;
+    reg.ring_entries = kRecvBufCount;
+    reg.bgid = kBufGroup;
+    if (ioUringRegister(_ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        LOG_WARN << "io_uring注册buffer ring: " << strerror(errno) << "，io_uring只做就绪通知";
+        munmap(bufs, bufsSize);
+        munmap(ring, ringSize);
+        return false;
+    }
+    _bufRing = static_cast<struct io_uring_buf *>(ring);
+    _recvBufs = static_cast<char *>(bufs);
+    for (unsigned i = 0; i < kRecvBufCount; ++i) {
+        _lentBufs.push_back((uint16_t)i);
+    }
+    recycleBuffers();
+    return true;
+}
+
+bool IoUringPoller::isValid() {
+    return _ringFd >= 0;
+}
+
+bool IoUringPoller::isCompletionBased() {
+    return _completion;
+}
+
+const vector<Completion> *IoUringPoller::completions() {
+    return _completion ? &_completions : nullptr;
+}
+
+uint64_t IoUringPoller::userData(int fd, uint32_t seq, unsigned op) {
+    return ((uint64_t)seq << 32) | ((uint64_t)op << 28) | ((uint32_t)fd & kFdMask);
+}
+
+uint32_t IoUringPoller::newSeq() {
+    // 0表示没有请求，回绕时跳过
+    if (++_nextSeq == 0) {
+        ++_nextSeq;
+    }
+    return _nextSeq;
+}
+
+IoUringPoller::Registration &IoUringPoller::regOf(int fd) {
+    if ((size_t)fd >= _regs.size()) {
+        _regs.resize((size_t)fd + 1 > 2 * _regs.size() ? (size_t)fd + 1 : 2 * _regs.size());
+    }
+    return _regs[fd];
+}
+
+bool IoUringPoller::needsPoll(const Registration &reg) {
+    return !reg.conn || (reg.events & ~(uint32_t)(EPOLLIN | EPOLLRDHUP | EPOLLET)) != 0;
+}
+
+struct io_uring_sqe *IoUringPoller::getSqe() {
+    unsigned head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+    if (_sqLocalTail - head >= _sqEntries) {
+        // 提交队列已满，先提交一批
+        enter(0, 0, nullptr, 0);
+        head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+        if (_sqLocalTail - head >= _sqEntries) {
+            return nullptr;
+        }
+    }
+    unsigned index = _sqLocalTail & _sqMask;
+    struct io_uring_sqe *sqe = &_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    _sqArray[index] = index;
+    ++_sqLocalTail;
+    ++_toSubmit;
+    return sqe;
+}
+
+int IoUringPoller::enter(unsigned minComplete, unsigned flags, void *arg, size_t argSize) {
+    __atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+    int ret = ioUringEnter(_ringFd, _toSubmit, minComplete, flags, arg, argSize);
+    if (ret >= 0) {
+        _toSubmit -= ((unsigned)ret < _toSubmit ? (unsigned)ret : _toSubmit);
+    }
+    return ret;
+}
+
+void IoUringPoller::armPoll(int fd) {
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe) {
+        LOG_ERROR << "io_uring提交队列已满，fd " << fd << " 未注册";
+        return;
+    }
+    Registration &reg = _regs[fd];
+    reg.seq = newSeq();
+    uint32_t events = reg.events & ~(uint32_t)EPOLLET;
+    if (reg.conn) {
+        events &= ~(uint32_t)(EPOLLIN | EPOLLRDHUP);
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events;
+    sqe->len = (_multishot && (reg.events & EPOLLET)) ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = userData(fd, reg.seq);
+}
+
+void IoUringPoller::removePoll(int fd) {
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = userData(fd, _regs[fd].seq);
+    sqe->user_data = kRemoveTag;
+}
+
+void IoUringPoller::armAccept(int fd) {
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe) {
+        LOG_ERROR << "io_uring提交队列已满，fd " << fd << " 无法accept";
+        return;
+    }
+    Registration &reg = _regs[fd];
+    reg.recvSeq = newSeq();
+    reg.recvArmed = true;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = userData(fd, reg.recvSeq, kOpAccept);
+}
+
+void IoUringPoller::armRecv(int fd) {
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe) {
+        LOG_ERROR << "io_uring提交队列已满，fd " << fd << " 无法recv";
+        return;
+    }
+    Registration &reg = _regs[fd];
+    reg.recvSeq = newSeq();
+    reg.recvArmed = true;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufGroup;
+    sqe->user_data = userData(fd, reg.recvSeq, kOpRecv);
+}
+
+void IoUringPoller::cancel(uint64_t target) {
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    sqe->user_data = kRemoveTag;
+}
+
+void IoUringPoller::recycleBuffers() {
+    if (_lentBufs.empty()) {
+        return;
+    }
+    // 只有本线程写tail；tail就是第0项的resv，只写各项的addr/len/bid
+    uint16_t tail = _bufRing[0].resv;
+    for (uint16_t bid : _lentBufs) {
+        struct io_uring_buf *buf = &_bufRing[tail & (kRecvBufCount - 1)];
+        buf->addr = (uint64_t)(uintptr_t)(_recvBufs + (size_t)bid * kRecvBufSize);
+        buf->len = kRecvBufSize;
+        buf->bid = bid;
+        ++tail;
+    }
+    __atomic_store_n(&_bufRing[0].resv, tail, __ATOMIC_RELEASE);
+    _lentBufs.clear();
+}
+
+void IoUringPoller::addFd(int fd, uint32_t events) {
+    Registration &reg = regOf(fd);
+    reg = Registration();
+    reg.active = true;
+    reg.events = events;
+    armPoll(fd);
+}
+
+void IoUringPoller::addListener(int fd) {
+    if (!_completion) {
+        addFd(fd, EPOLLIN);
+        return;
+    }
+    Registration &reg = regOf(fd);
+    reg = Registration();
+    reg.active = true;
+    reg.listener = true;
+    reg.events = EPOLLIN;
+    // 只写入提交队列，第一次poll()时才提交，那时监听套接字已经listen
+    armAccept(fd);
+}
+
+void IoUringPoller::addConnection(int fd, uint32_t events) {
+    if (!_completion) {
+        addFd(fd, events);
+        return;
+    }
+    Registration &reg = regOf(fd);
+    reg = Registration();
+    reg.active = true;
+    reg.conn = true;
+    reg.events = events;
+    if (needsPoll(reg)) {
+        armPoll(fd);
+    }
+    if (events & EPOLLIN) {
+        armRecv(fd);
+    }
+}
+
+void IoUringPoller::modFd(int fd, uint32_t events) {
+    if ((size_t)fd >= _regs.size() || !_regs[fd].active || _regs[fd].listener) {
+        return;
+    }
+    Registration &reg = _regs[fd];
+    if (!reg.conn) {
+        removePoll(fd);
+        reg.events = events;
+        armPoll(fd);
+        return;
+    }
+    // 连接：POLL_ADD只负责EPOLLIN以外的事件，变化时重新提交
+    uint32_t recvBits = EPOLLIN | EPOLLRDHUP;
+    bool pollChanged = (reg.events & ~recvBits) != (events & ~recvBits);
+    if (pollChanged && needsPoll(reg)) {
+        removePoll(fd);
+        reg.seq = 0;
+    }
+    reg.events = events;
+    if (pollChanged && needsPoll(reg)) {
+        armPoll(fd);
+    }
+    // 取消后，已经读出来的数据仍会在最后一个recv完成事件之前送达
+    // 恢复读取时如果旧的recv还没结束，等它结束后再重新提交
+    if ((events & EPOLLIN) && !reg.recvArmed) {
+        armRecv(fd);
+    } else if (!(events & EPOLLIN) && reg.recvArmed) {
+        cancel(userData(fd, reg.recvSeq, kOpRecv));
+    }
+}
+
+void IoUringPoller::delFd(int fd) {
+    if ((size_t)fd >= _regs.size() || !_regs[fd].active) {
+        return;
+    }
+    Registration &reg = _regs[fd];
+    if (!reg.listener && needsPoll(reg)) {
+        removePoll(fd);
+    }
+    // 请求持有socket的引用，不取消的话close之后连接也不会真正关闭
+    if (reg.recvArmed) {
+        cancel(userData(fd, reg.recvSeq, reg.listener ? kOpAccept : kOpRecv));
+    }
+    if (reg.sendSeq != 0) {
+        cancel(userData(fd, reg.sendSeq, kOpSend));
+    }
+    reg = Registration();
+}
+
+bool IoUringPoller::submitSend(int fd, const struct msghdr *msg) {
+    if (!_completion || (size_t)fd >= _regs.size() || !_regs[fd].active) {
+        return false;
+    }
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe) {
+        LOG_ERROR << "io_uring提交队列已满，fd " << fd << " 无法发送";
+        return false;
+    }
+    Registration &reg = _regs[fd];
+    reg.sendSeq = newSeq();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = userData(fd, reg.sendSeq, kOpSend);
+    return true;
+}
+
+void IoUringPoller::cancelSend(int fd) {
+    if ((size_t)fd < _regs.size() && _regs[fd].active && _regs[fd].sendSeq != 0) {
+        cancel(userData(fd, _regs[fd].sendSeq, kOpSend));
+    }
+}
+
+bool IoUringPoller::handleCqe(const struct io_uring_cqe *cqe, struct epoll_event *event) {
+    const char *data = nullptr;
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        // 不论请求是否已经过期，缓冲区都要在下一轮归还
+        uint16_t bid = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        _lentBufs.push_back(bid);
+        data = _recvBufs + (size_t)bid * kRecvBufSize;
+    }
+    if (cqe->user_data == kRemoveTag) {
+        return false;
+    }
+    int fd = (int)(cqe->user_data & kFdMask);
+    unsigned op = (unsigned)(cqe->user_data >> 28) & 0xf;
+    uint32_t seq = (uint32_t)(cqe->user_data >> 32);
+    if ((size_t)fd >= _regs.size() || !_regs[fd].active) {
+        return false; // 已删除的fd上旧请求的事件
+    }
+    Registration &reg = _regs[fd];
+    bool more = cqe->flags & IORING_CQE_F_MORE;
+    int res = cqe->res;
+    if (op == kOpPoll) {
+        if (reg.seq != seq) {
+            return false; // 已修改的旧请求
+        }
+        if (res < 0) {
+            if (res == -EINVAL && _multishot && (reg.events & EPOLLET)) {
+                _multishot = false; // 内核不支持multishot poll，改为每次重新提交
+            }
+            if (!more) {
+                armPoll(fd);
+            }
+            return false;
+        }
+        event->events = (uint32_t)res;
+        event->data.fd = fd;
+        if (!more) {
+            armPoll(fd); // 单次poll，或multishot被内核终止
+        }
+        return true;
+    }
+    if (op == kOpSend) {
+        if (reg.sendSeq != seq) {
+            return false;
+        }
+        reg.sendSeq = 0;
+        _completions.push_back(Completion{CompletionType::Send, fd, res, nullptr});
+        return false;
+    }
+    if (reg.recvSeq != seq) {
+        return false;
+    }
+    // buffer ring用完(ENOBUFS)或被取消时没有数据，不交给EventLoop
+    if (res != -ENOBUFS && res != -ECANCELED) {
+        CompletionType type = op == kOpAccept ? CompletionType::Accept : CompletionType::Recv;
+        _completions.push_back(Completion{type, fd, res, data});
+    }
+    if (!more) {
+        reg.recvArmed = false;
+        if (op == kOpAccept) {
+            if (res == -EINVAL) {
+                LOG_ERROR << "fd " << fd << " multishot accept: " << strerror(EINVAL); // 没有listen，重新提交也会失败
+            } else {
+                armAccept(fd);
+            }
+        } else if ((res > 0 || res == -ENOBUFS || res == -ECANCELED) && (reg.events & EPOLLIN)) {
+            // EOF和出错之后不再接收
+            armRecv(fd);
+        }
+    }
+    return false;
+}
+
+int IoUringPoller::poll(struct epoll_event *events, int maxEvents, int timeoutMs) {
+    if (_completion) {
+        // 上一轮的数据EventLoop已经拷走，缓冲区放回ring
+        _completions.clear();
+        recycleBuffers();
+    }
+    unsigned head = *_cqHead;
+    if (head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE)) {
+        // 完成队列为空，提交并等待
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg arg;
+        unsigned flags = 0;
+        unsigned minComplete = 0;
+        void *argPtr = nullptr;
+        size_t argSize = 0;
+        if (timeoutMs != 0) {
+            flags |= IORING_ENTER_GETEVENTS;
+            minComplete = 1;
+        }
+        if (timeoutMs > 0 && _hasExtArg) {
+            ts.tv_sec = timeoutMs / 1000;
+            ts.tv_nsec = (timeoutMs % 1000) * 1000000LL;
+            memset(&arg, 0, sizeof(arg));
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+            flags |= IORING_ENTER_EXT_ARG;
+            argPtr = &arg;
+            argSize = sizeof(arg);
+        }
+        int ret = enter(minComplete, flags, argPtr, argSize);
+        if (ret < 0 && errno != ETIME && errno != EBUSY) {
+            return -1;
+        }
+    } else if (_toSubmit > 0) {
+        // 已有完成事件，顺便提交积攒的请求，不等待
+        enter(0, 0, nullptr, 0);
+    }
+
+    int count = 0;
+    unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail && count < maxEvents) {
+        struct io_uring_cqe *cqe = &_cqes[head & _cqMask];
+        ++head;
+        if (handleCqe(cqe, &events[count])) {
+            ++count;
+        }
+    }
+    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+    return count;
+}
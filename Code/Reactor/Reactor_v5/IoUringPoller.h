@@ -0,0 +1,135 @@
+#ifndef _IO_URING_POLLER_H
+#define _IO_URING_POLLER_H
+
+#include "Poller.h"
+#include <linux/io_uring.h>
+#include <vector>
+
+using std::vector;
+
+// 基于io_uring的Poller，直接使用系统调用，不依赖liburing
+// 注册、修改、重新提交、发送都只写入提交队列，在下一次poll()时和等待合并为一次io_uring_enter
+//
+// 就绪模式(5.13+)：每个fd对应一个IORING_OP_POLL_ADD请求，只是代替epoll做就绪通知
+//   EPOLLET的fd使用multishot poll，一次提交持续产生事件
+//   水平触发的fd使用单次poll，每次触发后重新提交，条件仍满足时会立即再次触发
+// 完成模式(6.0+，能注册provided buffer ring时自动开启)：
+//   监听套接字提交一个multishot accept，新连接的fd直接出现在完成队列中
+//   连接提交一个multishot recv，数据由内核写进buffer ring中的缓冲区，下一次poll()时归还
+//   submitSend提交IORING_OP_SENDMSG，一轮里所有连接的发送和等待合并为一次io_uring_enter
+//   连接的POLL_ADD只剩EPOLLOUT(sendfile等发送缓冲区)；eventfd、timerfd仍按就绪模式处理
+class IoUringPoller : public Poller {
+public:
+    explicit IoUringPoller(unsigned entries = 4096);
+
+    ~IoUringPoller();
+
+    // 内核不支持io_uring时返回false
+    bool isValid();
+
+    void addFd(int fd, uint32_t events) override;
+
+    void modFd(int fd, uint32_t events) override;
+
+    void delFd(int fd) override;
+
+    int poll(struct epoll_event *events, int maxEvents, int timeoutMs) override;
+
+    bool isCompletionBased() override;
+
+    void addListener(int fd) override;
+
+    void addConnection(int fd, uint32_t events) override;
+
+    bool submitSend(int fd, const struct msghdr *msg) override;
+
+    void cancelSend(int fd) override;
+
+    const vector<Completion> *completions() override;
+
+private:
+    struct Registration {
+        bool active = false;   // 已注册
+        bool listener = false; // 完成模式下的监听套接字，用accept代替poll
+        bool conn = false;     // 完成模式下的连接，可读由recv代替poll
+        bool recvArmed = false; // accept/recv请求还没结束(最后一个完成事件没有IORING_CQE_F_MORE)
+        uint32_t events = 0;
+        // 每次提交请求时分配新的序号，完成事件的序号对不上时说明请求已被替换或fd已删除
+        uint32_t seq = 0;     // POLL_ADD
+        uint32_t recvSeq = 0; // accept/recv
+        uint32_t sendSeq = 0; // 正在进行的发送，0表示没有
+    };
+
+    int _ringFd;
+    bool _hasExtArg;
+    bool _multishot;
+    bool _completion; // 完成模式
+
+    void *_sqRing;
+    size_t _sqRingSize;
+    void *_cqRing;
+    size_t _cqRingSize;
+    struct io_uring_sqe *_sqes;
+    size_t _sqesSize;
+
+    unsigned *_sqHead;
+    unsigned *_sqTail;
+    unsigned _sqMask;
+    unsigned _sqEntries;
+    unsigned *_sqArray;
+    unsigned _sqLocalTail; // 已填写但还没提交给内核的位置
+    unsigned _toSubmit;
+
+    unsigned *_cqHead;
+    unsigned *_cqTail;
+    unsigned _cqMask;
+    struct io_uring_cqe *_cqes;
+
+    vector<Registration> _regs; // 以fd为下标
+    uint32_t _nextSeq;
+
+    // provided buffer ring：recv时由内核挑选缓冲区，完成事件里带回缓冲区编号
+    // 内核头文件里io_uring_buf_ring的bufs用空结构体占位，C++中空结构体占1字节，偏移不对，
+    // 这里直接当作io_uring_buf数组使用
+    struct io_uring_buf *_bufRing;
+    char *_recvBufs;
+    vector<uint16_t> _lentBufs; // 本轮交给EventLoop的缓冲区，下一次poll()时放回ring
+    vector<Completion> _completions;
+
+    bool setup(unsigned entries);
+
+    // 探测并注册buffer ring，成功时开启完成模式
+    bool setupCompletion();
+
+    struct io_uring_sqe *getSqe();
+
+    // 提交队列中所有请求，并按需等待完成
+    int enter(unsigned minComplete, unsigned flags, void *arg, size_t argSize);
+
+    uint32_t newSeq();
+
+    Registration &regOf(int fd);
+
+    // 完成模式下的连接只对EPOLLOUT等提交POLL_ADD
+    bool needsPoll(const Registration &reg);
+
+    void armPoll(int fd);
+
+    void removePoll(int fd);
+
+    void armAccept(int fd);
+
+    void armRecv(int fd);
+
+    // 按user_data取消请求，不按fd取消：fd关闭后编号会被新连接复用
+    void cancel(uint64_t userData);
+
+    void recycleBuffers();
+
+    // 处理一个完成事件，是就绪事件时写入event并返回true
+    bool handleCqe(const struct io_uring_cqe *cqe, struct epoll_event *event);
+
+    static uint64_t userData(int fd, uint32_t seq, unsigned op = 0);
+};
+
+#endif
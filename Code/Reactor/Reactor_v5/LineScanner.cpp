@@ -0,0 +1,47 @@
+#include "LineScanner.h"
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// glibc的memchr本身按CPU选择了AVX2/EVEX实现，中长行上比自己写的向量循环更快(见bench/LineScannerBench.cpp)
+// 短行时函数调用和对齐处理的固定开销占大头，先用一次16字节比较看开头，命中就不必调用memchr
+const char *LineScanner::find(const char *begin, const char *end, char c) {
+    if (begin >= end) {
+        return nullptr;
+    }
+#ifdef __SSE2__
+    if (end - begin >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)));
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+        begin += 16;
+    }
+#endif
+    return static_cast<const char *>(memchr(begin, c, end - begin));
+}
+
+size_t LineScanner::scanLines(const char *data, size_t len, vector<LineView> *lines) {
+    const char *end = data + len;
+    const char *lineStart = data;
+    while (lineStart < end) {
+        const char *eol = find(lineStart, end, '\n');
+        if (!eol) {
+            break;
+        }
+        lines->push_back(LineView{lineStart, static_cast<size_t>(eol - lineStart)});
+        lineStart = eol + 1;
+    }
+    return lineStart - data;
+}
+
+const char *LineScanner::implName() {
+#ifdef __SSE2__
+    return "sse2+memchr";
+#else
+    return "memchr";
+#endif
+}
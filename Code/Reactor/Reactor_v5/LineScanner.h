@@ -0,0 +1,31 @@
+#ifndef _LINESCANNER_H
+#define _LINESCANNER_H
+
+#include <stddef.h>
+#include <vector>
+
+using std::vector;
+
+// 指向缓冲区内一行数据的视图，不包含结尾的'\n'
+// 只在缓冲区被retrieve或写入之前有效
+struct LineView {
+    const char *data;
+    size_t len;
+};
+
+// 按'\n'切分已缓冲的输入
+// 查找基于glibc的memchr，x86上先用SSE2比较开头16字节，短行不必调用memchr
+class LineScanner {
+public:
+    // [begin, end)中第一个c的位置，没有时返回nullptr
+    static const char *find(const char *begin, const char *end, char c);
+
+    // 把data中所有完整的行追加到lines，返回这些行（含'\n'）占用的字节数
+    // 最后一段没有'\n'的数据不算完整的行，留给下一次读取
+    static size_t scanLines(const char *data, size_t len, vector<LineView> *lines);
+
+    // 当前使用的实现："sse2+memchr"或"memchr"
+    static const char *implName();
+};
+
+#endif //_LINESCANNER_H
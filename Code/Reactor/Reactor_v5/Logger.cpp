@@ -0,0 +1,362 @@
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <errno.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+const char *const kLevelNames[] = {"TRACE ", "DEBUG ", "INFO  ", "WARN  ", "ERROR "};
+
+// 后台线程没有日志时的等待时间
+const int kIdleWaitMs = 10;
+
+// 每个线程缓存自己的LogRing和线程号，线程退出时放开LogRing，剩余日志由后台线程取完后释放
+struct ThreadLogState {
+    shared_ptr<LogRing> ring;
+    int tid = 0;
+    time_t lastSecond = -1;
+    char timeStr[24]; // "20260101 12:00:00."，同一秒内不再调用localtime_r
+};
+
+thread_local ThreadLogState t_log;
+
+int currentTid() {
+    if (t_log.tid == 0) {
+        t_log.tid = static_cast<int>(::syscall(SYS_gettid));
+    }
+    return t_log.tid;
+}
+
+// 把无符号整数按十进制写到buf，返回长度
+size_t formatUnsigned(char *buf, unsigned long long v) {
+    char tmp[24];
+    size_t n = 0;
+    do {
+        tmp[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    for (size_t i = 0; i < n; ++i) {
+        buf[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+size_t formatSigned(char *buf, long long v) {
+    if (v < 0) {
+        buf[0] = '-';
+        return 1 + formatUnsigned(buf + 1, 0ULL - static_cast<unsigned long long>(v));
+    }
+    return formatUnsigned(buf, static_cast<unsigned long long>(v));
+}
+
+}
+
+LogRing::LogRing(size_t capacity)
+    : _mask(0), _head(0), _tail(0) {
+    size_t size = 1024;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    _buf.resize(size);
+    _mask = size - 1;
+}
+
+bool LogRing::push(const char *data, size_t len) {
+    size_t need = sizeof(uint32_t) + len;
+    size_t head = _head.load(std::memory_order_relaxed);
+    size_t tail = _tail.load(std::memory_order_acquire);
+    if (_buf.size() - (head - tail) < need) {
+        return false;
+    }
+    uint32_t len32 = static_cast<uint32_t>(len);
+    copyIn(head, &len32, sizeof(len32));
+    copyIn(head + sizeof(len32), data, len);
+    _head.store(head + need, std::memory_order_release);
+    return true;
+}
+
+size_t LogRing::drain(string *out) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    size_t head = _head.load(std::memory_order_acquire);
+    size_t count = 0;
+    while (tail != head) {
+        uint32_t len32 = 0;
+        copyOut(tail, &len32, sizeof(len32));
+        size_t old = out->size();
+        out->resize(old + len32);
+        copyOut(tail + sizeof(len32), &(*out)[old], len32);
+        tail += sizeof(len32) + len32;
+        ++count;
+    }
+    _tail.store(tail, std::memory_order_release);
+    return count;
+}
+
+bool LogRing::isEmpty() {
+    return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_relaxed);
+}
+
+void LogRing::copyIn(size_t pos, const void *data, size_t len) {
+    size_t off = pos & _mask;
+    size_t first = std::min(len, _buf.size() - off);
+    memcpy(&_buf[off], data, first);
+    memcpy(&_buf[0], static_cast<const char *>(data) + first, len - first);
+}
+
+void LogRing::copyOut(size_t pos, void *data, size_t len) {
+    size_t off = pos & _mask;
+    size_t first = std::min(len, _buf.size() - off);
+    memcpy(data, &_buf[off], first);
+    memcpy(static_cast<char *>(data) + first, &_buf[0], len - first);
+}
+
+atomic<int> Logger::s_level(kLogInfo);
+
+Logger &Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : _running(false), _stopping(false), _file(nullptr), _ownFile(false), _flushIntervalMs(1000), _ringSize(1 << 20), _dropped(0) {}
+
+Logger::~Logger() {
+    stop();
+}
+
+bool Logger::start(const string &path, int flushIntervalMs) {
+    if (_running.load()) {
+        return true;
+    }
+    if (path.empty()) {
+        _file = stdout;
+        _ownFile = false;
+    } else {
+        _file = fopen(path.c_str(), "a");
+        if (_file == nullptr) {
+            perror("fopen");
+            return false;
+        }
+        _ownFile = true;
+    }
+    _flushIntervalMs = flushIntervalMs;
+    _stopping = false;
+    _running.store(true);
+    _thread = std::thread(&Logger::threadFunc, this);
+    return true;
+}
+
+void Logger::stop() {
+    if (!_running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _cond.notify_one();
+    _thread.join();
+    fflush(_file);
+    if (_ownFile) {
+        fclose(_file);
+    }
+    _file = nullptr;
+}
+
+void Logger::setLevel(LogLevel level) {
+    s_level.store(level, std::memory_order_relaxed);
+}
+
+void Logger::setRingSize(size_t bytes) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _ringSize = bytes;
+}
+
+uint64_t Logger::dropped() {
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+void Logger::append(const char *data, size_t len) {
+    if (!_running.load(std::memory_order_acquire)) {
+        // 没有后台线程，直接写stderr，一次write保证整行不被其他线程打断
+        ssize_t ret = ::write(STDERR_FILENO, data, len);
+        (void)ret;
+        return;
+    }
+    if (!threadRing()->push(data, len)) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+LogRing *Logger::threadRing() {
+    if (!t_log.ring) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        t_log.ring = std::make_shared<LogRing>(_ringSize);
+        _rings.push_back(t_log.ring);
+    }
+    return t_log.ring.get();
+}
+
+size_t Logger::drainAll(string *batch) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t count = 0;
+    for (size_t i = 0; i < _rings.size();) {
+        // 先判断线程是否已退出再取，取完之后不会再有新日志
+        bool abandoned = _rings[i].use_count() == 1;
+        count += _rings[i]->drain(batch);
+        if (abandoned) {
+            _rings[i] = std::move(_rings.back());
+            _rings.pop_back();
+        } else {
+            ++i;
+        }
+    }
+    return count;
+}
+
+void Logger::threadFunc() {
+    using std::chrono::steady_clock;
+    string batch;
+    batch.reserve(1 << 20);
+    steady_clock::time_point lastFlush = steady_clock::now();
+    uint64_t reportedDrops = 0;
+    while (true) {
+        batch.clear();
+        size_t count = drainAll(&batch);
+        uint64_t drops = dropped();
+        if (drops != reportedDrops) {
+            batch += "日志缓冲区已满，丢弃了";
+            batch += std::to_string(drops - reportedDrops);
+            batch += "条日志\n";
+            reportedDrops = drops;
+        }
+        if (!batch.empty()) {
+            fwrite(batch.data(), 1, batch.size(), _file);
+        }
+        steady_clock::time_point now = steady_clock::now();
+        if (now - lastFlush >= std::chrono::milliseconds(_flushIntervalMs)) {
+            fflush(_file);
+            lastFlush = now;
+        }
+        if (count > 0) {
+            // 还有日志在写入，不等待，继续取
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_stopping) {
+            break;
+        }
+        // 写日志的线程不通知，避免在业务线程上多一次系统调用，这里按固定间隔轮询
+        _cond.wait_for(lock, std::chrono::milliseconds(kIdleWaitMs));
+    }
+    // stop之前已写入LogRing的日志
+    batch.clear();
+    drainAll(&batch);
+    fwrite(batch.data(), 1, batch.size(), _file);
+}
+
+LogLine::LogLine(LogLevel level, const char *file, int line)
+    : _len(0) {
+    // 调用处常写 LOG_WARN << strerror(errno)，C++11中构造和<<右边谁先求值不确定，
+    // localtime_r等调用不能改掉errno
+    int savedErrno = errno;
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    if (tv.tv_sec != t_log.lastSecond) {
+        struct tm tmv;
+        localtime_r(&tv.tv_sec, &tmv);
+        strftime(t_log.timeStr, sizeof(t_log.timeStr), "%Y%m%d %H:%M:%S.", &tmv);
+        t_log.lastSecond = tv.tv_sec;
+    }
+    size_t timeLen = strlen(t_log.timeStr);
+    memcpy(_buf, t_log.timeStr, timeLen);
+    _len = timeLen;
+    // 微秒固定6位
+    int usec = static_cast<int>(tv.tv_usec);
+    for (int i = 5; i >= 0; --i) {
+        _buf[_len + i] = static_cast<char>('0' + usec % 10);
+        usec /= 10;
+    }
+    _len += 6;
+    _buf[_len++] = ' ';
+    memcpy(_buf + _len, kLevelNames[level], 6);
+    _len += 6;
+    *this << currentTid() << ' ';
+    const char *slash = strrchr(file, '/');
+    *this << (slash ? slash + 1 : file) << ':' << line << ' ';
+    errno = savedErrno;
+}
+
+LogLine::~LogLine() {
+    // 截断时也保留换行
+    if (_len == kMaxLine) {
+        --_len;
+    }
+    _buf[_len++] = '\n';
+    Logger::instance().append(_buf, _len);
+}
+
+LogLine &LogLine::write(const char *data, size_t len) {
+    // 留一个字节给换行
+    size_t avail = kMaxLine - 1 - _len;
+    if (len > avail) {
+        len = avail;
+    }
+    memcpy(_buf + _len, data, len);
+    _len += len;
+    return *this;
+}
+
+LogLine &LogLine::operator<<(const char *str) {
+    return write(str, strlen(str));
+}
+
+LogLine &LogLine::operator<<(const string &str) {
+    return write(str.data(), str.size());
+}
+
+LogLine &LogLine::operator<<(char c) {
+    return write(&c, 1);
+}
+
+LogLine &LogLine::operator<<(int v) {
+    return *this << static_cast<long long>(v);
+}
+
+LogLine &LogLine::operator<<(unsigned v) {
+    return *this << static_cast<unsigned long long>(v);
+}
+
+LogLine &LogLine::operator<<(long v) {
+    return *this << static_cast<long long>(v);
+}
+
+LogLine &LogLine::operator<<(unsigned long v) {
+    return *this << static_cast<unsigned long long>(v);
+}
+
+LogLine &LogLine::operator<<(long long v) {
+    char tmp[24];
+    return write(tmp, formatSigned(tmp, v));
+}
+
+LogLine &LogLine::operator<<(unsigned long long v) {
+    char tmp[24];
+    return write(tmp, formatUnsigned(tmp, v));
+}
+
+LogLine &LogLine::operator<<(double v) {
+    char tmp[32];
+    int n = snprintf(tmp, sizeof(tmp), "%g", v);
+    return write(tmp, n > 0 ? static_cast<size_t>(n) : 0);
+}
+
+LogLine &LogLine::operator<<(const void *p) {
+    char tmp[24];
+    int n = snprintf(tmp, sizeof(tmp), "%p", p);
+    return write(tmp, n > 0 ? static_cast<size_t>(n) : 0);
+}
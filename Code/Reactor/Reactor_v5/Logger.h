@@ -0,0 +1,189 @@
+#ifndef _LOGGER_H
+#define _LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::atomic;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+enum LogLevel {
+    kLogTrace = 0,
+    kLogDebug,
+    kLogInfo,
+    kLogWarn,
+    kLogError,
+    kLogOff
+};
+
+// 编译期日志级别：低于它的LOG_*整条语句被编译器去掉，如 -DLOG_COMPILE_LEVEL=kLogWarn
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL kLogTrace
+#endif
+
+// 单生产者/单消费者的字节环形缓冲区，每条日志存为[uint32_t长度][内容]
+// 生产者是拥有它的线程，消费者是后台写线程，两边都不加锁
+class LogRing {
+public:
+    // capacity向上取为2的幂
+    explicit LogRing(size_t capacity);
+
+    // 空间不够时丢弃这条日志并返回false，日志线程永远不会阻塞业务线程
+    bool push(const char *data, size_t len);
+
+    // 把已写入的日志全部追加到out，返回取出的条数
+    size_t drain(string *out);
+
+    bool isEmpty();
+
+private:
+    vector<char> _buf;
+    size_t _mask;
+    atomic<size_t> _head; // 生产者写到的位置，只增不减
+    atomic<size_t> _tail; // 消费者读到的位置，只增不减
+
+    void copyIn(size_t pos, const void *data, size_t len);
+
+    void copyOut(size_t pos, void *data, size_t len);
+};
+
+// 异步日志：每个线程第一次写日志时分配自己的LogRing，
+// 后台线程轮询所有LogRing，批量fwrite到文件，每隔flushInterval调用一次fflush
+// start之前的日志直接同步写到stderr
+class Logger {
+public:
+    static Logger &instance();
+
+    // path为空时写到stdout；flushIntervalMs：定期fflush的间隔
+    bool start(const string &path = string(), int flushIntervalMs = 1000);
+
+    // 写出所有线程中剩余的日志并结束后台线程
+    void stop();
+
+    // 运行期日志级别，默认kLogInfo
+    static void setLevel(LogLevel level);
+
+    static LogLevel level() {
+        return static_cast<LogLevel>(s_level.load(std::memory_order_relaxed));
+    }
+
+    // 之后新线程的LogRing大小，已经分配的不变
+    void setRingSize(size_t bytes);
+
+    // 由LogLine调用：写入当前线程的LogRing
+    void append(const char *data, size_t len);
+
+    // 因LogRing满而丢弃的日志条数
+    uint64_t dropped();
+
+    ~Logger();
+
+private:
+    static atomic<int> s_level;
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    vector<shared_ptr<LogRing>> _rings; // 受_mutex保护，线程退出且已取空的由后台线程移除
+    std::thread _thread;
+    atomic<bool> _running;
+    bool _stopping;
+    FILE *_file;
+    bool _ownFile;
+    int _flushIntervalMs;
+    size_t _ringSize;
+    atomic<uint64_t> _dropped;
+
+    Logger();
+
+    LogRing *threadRing();
+
+    void threadFunc();
+
+    // 取出所有LogRing中的日志写入文件，返回取出的条数
+    size_t drainAll(string *batch);
+
+    Logger(const Logger &) = delete;
+
+    Logger &operator=(const Logger &) = delete;
+};
+
+// 按长度输出的一段数据，内容中可以有'\0'
+struct LogData {
+    const char *data;
+    size_t len;
+
+    LogData(const char *d, size_t l) : data(d), len(l) {}
+};
+
+// 一条日志的格式化缓冲区：在栈上拼好"时间 级别 线程 文件:行 内容\n"，析构时交给Logger
+// 超过kMaxLine的部分被截断
+class LogLine {
+public:
+    static const size_t kMaxLine = 4096;
+
+    LogLine(LogLevel level, const char *file, int line);
+
+    ~LogLine();
+
+    LogLine &operator<<(const char *str);
+
+    LogLine &operator<<(const string &str);
+
+    LogLine &operator<<(char c);
+
+    LogLine &operator<<(int v);
+
+    LogLine &operator<<(unsigned v);
+
+    LogLine &operator<<(long v);
+
+    LogLine &operator<<(unsigned long v);
+
+    LogLine &operator<<(long long v);
+
+    LogLine &operator<<(unsigned long long v);
+
+    LogLine &operator<<(double v);
+
+    LogLine &operator<<(const void *p);
+
+    LogLine &operator<<(const LogData &d) {
+        return write(d.data, d.len);
+    }
+
+    LogLine &write(const char *data, size_t len);
+
+private:
+    char _buf[kMaxLine];
+    size_t _len;
+
+    LogLine(const LogLine &) = delete;
+
+    LogLine &operator=(const LogLine &) = delete;
+};
+
+// 级别不够时不会构造LogLine，<<右边的表达式也不会求值
+#define LOG_ENABLED(lv) ((lv) >= LOG_COMPILE_LEVEL && (lv) >= Logger::level())
+
+#define LOG_AT(lv) \
+    if (!LOG_ENABLED(lv)) { \
+    } else \
+        LogLine(lv, __FILE__, __LINE__)
+
+#define LOG_TRACE LOG_AT(kLogTrace)
+#define LOG_DEBUG LOG_AT(kLogDebug)
+#define LOG_INFO LOG_AT(kLogInfo)
+#define LOG_WARN LOG_AT(kLogWarn)
+#define LOG_ERROR LOG_AT(kLogError)
+
+#endif
@@ -0,0 +1,92 @@
+#include "LoopStats.h"
+
+namespace {
+
+// 单写者计数器：不需要原子的读改写
+inline void bump(atomic<uint64_t> &counter, uint64_t delta) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+inline int bucketOf(uint64_t value) {
+    int bucket = value == 0 ? 0 : 64 - __builtin_clzll(value);
+    return bucket < HistogramSnapshot::kBuckets ? bucket : HistogramSnapshot::kBuckets - 1;
+}
+
+} // namespace
+
+double HistogramSnapshot::mean() const {
+    return count == 0 ? 0.0 : (double)sum / count;
+}
+
+uint64_t HistogramSnapshot::percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(p * count);
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += buckets[i];
+        if (seen > target) {
+            uint64_t upper = i == 0 ? 0 : (1ULL << i) - 1;
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+Histogram::Histogram() : _count(0), _sum(0), _max(0) {
+    for (auto &bucket : _buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::record(uint64_t value) {
+    bump(_buckets[bucketOf(value)], 1);
+    bump(_count, 1);
+    bump(_sum, value);
+    if (value > _max.load(std::memory_order_relaxed)) {
+        _max.store(value, std::memory_order_relaxed);
+    }
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot snap;
+    for (int i = 0; i < HistogramSnapshot::kBuckets; ++i) {
+        snap.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+    }
+    snap.count = _count.load(std::memory_order_relaxed);
+    snap.sum = _sum.load(std::memory_order_relaxed);
+    snap.max = _max.load(std::memory_order_relaxed);
+    return snap;
+}
+
+LoopStats::LoopStats() : _iterations(0), _eventsGrowths(0) {}
+
+void LoopStats::recordWakeup(int events, uint64_t dispatchNs) {
+    bump(_iterations, 1);
+    _eventsPerWakeup.record(events);
+    _dispatchNs.record(dispatchNs);
+}
+
+void LoopStats::recordEventsGrowth() {
+    bump(_eventsGrowths, 1);
+}
+
+void LoopStats::recordDrain(uint64_t tasks) {
+    _pendingPerDrain.record(tasks);
+}
+
+void LoopStats::recordPendingDelay(uint64_t delayNs) {
+    _pendingDelayNs.record(delayNs);
+}
+
+LoopStatsSnapshot LoopStats::snapshot() const {
+    LoopStatsSnapshot snap;
+    snap.iterations = _iterations.load(std::memory_order_relaxed);
+    snap.eventsGrowths = _eventsGrowths.load(std::memory_order_relaxed);
+    snap.dispatchNs = _dispatchNs.snapshot();
+    snap.eventsPerWakeup = _eventsPerWakeup.snapshot();
+    snap.pendingPerDrain = _pendingPerDrain.snapshot();
+    snap.pendingDelayNs = _pendingDelayNs.snapshot();
+    return snap;
+}
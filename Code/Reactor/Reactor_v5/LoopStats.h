@@ -0,0 +1,75 @@
+#ifndef _LOOP_STATS_H
+#define _LOOP_STATS_H
+
+#include <atomic>
+#include <cstdint>
+
+using std::atomic;
+
+// 直方图快照，第i个桶统计落在[2^(i-1), 2^i)的值，第0个桶统计0
+struct HistogramSnapshot {
+    static const int kBuckets = 40;
+
+    uint64_t buckets[kBuckets] = {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    double mean() const;
+
+    // 近似分位数(返回所在桶的上界)，p取值0~1
+    uint64_t percentile(double p) const;
+};
+
+// 以2的幂分桶的直方图
+// 只允许一个线程写入(所属EventLoop线程)，写入只用relaxed的load+store，没有原子读改写和锁
+// 其他线程可以随时调用snapshot()读取，读到的各字段之间可能相差正在进行的一次写入
+class Histogram {
+public:
+    Histogram();
+
+    void record(uint64_t value);
+
+    HistogramSnapshot snapshot() const;
+
+private:
+    atomic<uint64_t> _buckets[HistogramSnapshot::kBuckets];
+    atomic<uint64_t> _count;
+    atomic<uint64_t> _sum;
+    atomic<uint64_t> _max;
+};
+
+struct LoopStatsSnapshot {
+    uint64_t iterations = 0;            // 处理过事件的轮数
+    uint64_t eventsGrowths = 0;         // 就绪事件数组扩容次数
+    HistogramSnapshot dispatchNs;       // 每轮处理就绪事件的耗时(不含等待)，sum即累计忙碌时间
+    HistogramSnapshot eventsPerWakeup;  // 每次等待返回的就绪事件数
+    HistogramSnapshot pendingPerDrain;  // 每次doPendingTasks取出的任务数
+    HistogramSnapshot pendingDelayNs;   // 任务从queueInLoop到开始执行的延迟
+};
+
+// 每个EventLoop一份，只由EventLoop线程写入
+class LoopStats {
+public:
+    LoopStats();
+
+    void recordWakeup(int events, uint64_t dispatchNs);
+
+    void recordEventsGrowth();
+
+    void recordDrain(uint64_t tasks);
+
+    void recordPendingDelay(uint64_t delayNs);
+
+    LoopStatsSnapshot snapshot() const;
+
+private:
+    atomic<uint64_t> _iterations;
+    atomic<uint64_t> _eventsGrowths;
+    Histogram _dispatchNs;
+    Histogram _eventsPerWakeup;
+    Histogram _pendingPerDrain;
+    Histogram _pendingDelayNs;
+};
+
+#endif
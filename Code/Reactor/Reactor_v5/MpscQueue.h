@@ -0,0 +1,75 @@
+#ifndef _MPSC_QUEUE_H
+#define _MPSC_QUEUE_H
+
+#include <atomic>
+
+using std::atomic;
+
+// 无锁的多生产者/单消费者队列(Vyukov MPSC)
+// push可以在任意线程并发调用，pop只能由唯一的消费者线程调用
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : _head(new Node), _tail(_head.load()) {}
+
+    ~MpscQueue() {
+        T temp;
+        while (pop(temp)) {
+        }
+        delete _tail;
+    }
+
+    void push(T &&value) {
+        Node *node = new Node;
+        node->value = std::move(value);
+        Node *prev = _head.exchange(node, std::memory_order_acq_rel);
+        // 在下面这行执行之前，消费者暂时看不到node，但push返回前一定可见
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 队列为空时返回false
+    bool pop(T &value) {
+        Node *tail = _tail;
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+        value = std::move(next->value);
+        _tail = next; // next成为新的哨兵节点
+        delete tail;
+        return true;
+    }
+
+    // 取出调用时已在队列中的元素并依次交给func，之后新入队的留到下一次
+    // 避免生产者持续入队时消费者一直取不完
+    template <typename Func>
+    size_t consume(Func &&func) {
+        Node *last = _head.load(std::memory_order_acquire);
+        size_t count = 0;
+        T value;
+        while (_tail != last && pop(value)) {
+            func(value);
+            ++count;
+        }
+        return count;
+    }
+
+    bool isEmpty() {
+        return _tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        atomic<Node *> next{nullptr};
+        T value;
+    };
+
+    atomic<Node *> _head; // 生产者从这里插入
+    Node *_tail;          // 消费者从这里取出，总是指向哨兵节点
+
+    MpscQueue(const MpscQueue &) = delete;
+
+    MpscQueue &operator=(const MpscQueue &) = delete;
+};
+
+#endif
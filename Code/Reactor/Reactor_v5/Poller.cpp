@@ -0,0 +1,16 @@
+#include "Poller.h"
+#include "EpollPoller.h"
+#include "IoUringPoller.h"
+#include "Logger.h"
+
+Poller *Poller::newPoller(PollerType type) {
+    if (type == PollerType::IoUring) {
+        IoUringPoller *poller = new IoUringPoller();
+        if (poller->isValid()) {
+            return poller;
+        }
+        delete poller;
+        LOG_WARN << "io_uring不可用，使用epoll";
+    }
+    return new EpollPoller();
+}
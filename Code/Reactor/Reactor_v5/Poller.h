@@ -0,0 +1,82 @@
+#ifndef _POLLER_H
+#define _POLLER_H
+
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <vector>
+
+using std::vector;
+
+// IO多路复用后端
+enum class PollerType {
+    Epoll,  // 默认
+    IoUring // 需要Linux 5.13以上内核，不可用时退回epoll；6.0以上使用完成模式，见IoUringPoller
+};
+
+// 完成模式下由内核代为执行的操作
+enum class CompletionType {
+    Accept, // multishot accept得到一个新连接
+    Recv,   // multishot recv读到一段数据
+    Send    // submitSend提交的一次发送完成
+};
+
+// 完成模式的结果
+struct Completion {
+    CompletionType type;
+    int fd;           // 发起请求的fd，Accept为监听fd
+    int res;          // Accept：新连接的fd；Recv：读到的字节数，0为EOF；Send：发出的字节数；出错时为-errno
+    const char *data; // Recv读到的数据，在下一次poll()之前有效
+};
+
+// EventLoop使用的IO多路复用接口
+// 事件掩码和就绪结果统一使用epoll的EPOLLIN/EPOLLOUT/EPOLLET等标志和epoll_event结构
+// 完成模式(isCompletionBased()为true)：监听套接字和连接的可读不再作为就绪事件返回，
+// 由Poller发起accept/recv，结果放进completions()；发送也可以交给Poller批量提交
+class Poller {
+public:
+    virtual ~Poller() {}
+
+    virtual void addFd(int fd, uint32_t events) = 0;
+
+    virtual void modFd(int fd, uint32_t events) = 0;
+
+    virtual void delFd(int fd) = 0;
+
+    // 等待事件，timeoutMs为-1时一直等待
+    // 返回就绪事件数，出错时返回-1并设置errno；完成模式下返回0时completions()可能不为空
+    virtual int poll(struct epoll_event *events, int maxEvents, int timeoutMs) = 0;
+
+    virtual bool isCompletionBased() {
+        return false;
+    }
+
+    // 监听套接字，默认按EPOLLIN注册，由EventLoop自己accept
+    virtual void addListener(int fd) {
+        addFd(fd, EPOLLIN);
+    }
+
+    // 已建立的连接，完成模式下events中的EPOLLIN表示是否接收数据，其余同addFd
+    virtual void addConnection(int fd, uint32_t events) {
+        addFd(fd, events);
+    }
+
+    // 提交一次发送，在下一次poll()时和等待合并为一次系统调用；不支持时返回false
+    // msg及其指向的iovec和数据在Send完成之前必须保持有效
+    virtual bool submitSend(int fd, const struct msghdr *msg) {
+        return false;
+    }
+
+    // 取消fd上还没完成的发送，Send完成事件仍会返回
+    virtual void cancelSend(int fd) {}
+
+    // 上一次poll()得到的完成事件，不是完成模式时返回nullptr
+    virtual const vector<Completion> *completions() {
+        return nullptr;
+    }
+
+    // 按类型创建，io_uring不可用时返回epoll实现
+    static Poller *newPoller(PollerType type);
+};
+
+#endif
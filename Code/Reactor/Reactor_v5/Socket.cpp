@@ -1,13 +1,36 @@
 #include "Socket.h"
+#include "Logger.h"
+#include <errno.h>
+#include <string.h>
 
 Socket::Socket() : _fd(socket(AF_INET, SOCK_STREAM, 0)) {}
 
+Socket::Socket(int domain, int type) : _fd(socket(domain, type, 0)) {
+    if (_fd < 0) {
+        LOG_ERROR << "socket: " << strerror(errno);
+    }
+}
+
 Socket::Socket(int fd) : _fd(fd) {}
 
 Socket::~Socket() {
-    close(_fd);
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+void Socket::reset(int fd) {
+    if (_fd >= 0) {
+        close(_fd);
+    }
+    _fd = fd;
 }
 
 int Socket::getFd() {
     return _fd;
+}
+
+void Socket::setNonblock() {
+    int flags = fcntl(_fd, F_GETFL, 0);
+    fcntl(_fd, F_SETFL, flags | O_NONBLOCK);
 }
\ No newline at end of file
@@ -1,19 +1,44 @@
 #ifndef _SOCKET_H
 #define _SOCKET_H
 
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+// 监听套接字和accept得到的连接使用的选项
+// 都设置在监听套接字上，Linux的accept会把它们复制给新连接，不需要每个连接再调用setsockopt；
+// 只有TCP_QUICKACK不会保留，由TcpConnection每次读到数据后重新设置
+// Unix域套接字忽略TCP_*选项
+struct SocketOptions {
+    bool tcpNoDelay = true;  // 关闭Nagle，小的请求/回复不必等对端的延迟ACK
+    int recvBuf = 0;         // SO_RCVBUF，0表示内核默认(自动调整)，必须在listen之前设置窗口扩大才生效
+    int sendBuf = 0;         // SO_SNDBUF，0表示内核默认
+    int deferAcceptSec = 0;  // TCP_DEFER_ACCEPT：客户端发来数据(或超时)后才唤醒accept，0表示关闭
+    int fastOpenQueue = 0;   // TCP_FASTOPEN：等待中的TFO请求队列长度，0表示关闭
+    bool quickAck = false;   // TCP_QUICKACK：读到数据后立即回ACK，不等延迟ACK定时器
+    int lingerSec = -1;      // SO_LINGER：close时最多等待多少秒发完数据，0表示直接RST，-1表示不设置
+};
+
 class Socket {
 public:
+    // IPv4的TCP套接字
     Socket();
 
+    // domain为AF_INET/AF_INET6/AF_UNIX，type如SOCK_STREAM
+    Socket(int domain, int type);
+
     ~Socket();
 
     explicit Socket(int fd);
 
     int getFd();
 
+    // 关闭当前fd并接管新的fd，fd为-1时只关闭
+    void reset(int fd);
+
+    // 设置为非阻塞
+    void setNonblock();
+
 private:
     int _fd;
 
@@ -1,4 +1,5 @@
 #include "SocketIO.h"
+#include <string.h>
 
 SocketIO::SocketIO(int fd) : _fd(fd) {}
 
@@ -11,6 +12,8 @@ int SocketIO::readn(char *buf, int len) {
         if (readSize < 0) {
             if (errno == EINTR) {
                 readSize = 0;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break; // 非阻塞套接字已读空
             } else {
                 return -1;
             }
@@ -23,46 +26,75 @@ int SocketIO::readn(char *buf, int len) {
     return len - left;
 }
 
-int SocketIO::writen(const char *buf, int len) {
-    int left = len;
-    const char *ptr = buf;
-    int wrote = 0;
-    while (left > 0) {
-        wrote = write(_fd, ptr, left);
-        if (wrote < 0) {
-            if (errno == EINTR) {
-                wrote = 0;
-            } else {
-                return -1;
-            }
-        } else if (wrote == 0) {
-            break;
+ssize_t SocketIO::writevSome(const struct iovec *iov, int iovcnt, bool more) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = const_cast<struct iovec *>(iov);
+    msg.msg_iovlen = iovcnt;
+    int flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+    while (true) {
+        ssize_t wrote = ::sendmsg(_fd, &msg, flags);
+        if (wrote >= 0) {
+            return wrote;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        } else {
+            return -1;
         }
-        left -= wrote;
-        ptr += wrote;
     }
-    return len - left;
 }
 
-int SocketIO::readLine(char *buf, int len) {
-    int count = 0;
-    char c;
-    while (count < len - 1) {
-        int ret = read(_fd, &c, 1);
-        if (ret < 0) {
-            if (errno == EINTR) {
-                continue;
-            } else {
-                return -1;
-            }
-        } else if (ret == 0) {
-            break;
+ssize_t SocketIO::sendFile(int inFd, off_t *offset, size_t len) {
+    while (true) {
+        ssize_t sent = ::sendfile(_fd, inFd, offset, len);
+        if (sent > 0) {
+            return sent;
+        } else if (sent == 0) {
+            errno = ENODATA; // 文件比要求的短
+            return -1;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        } else {
+            return -1;
         }
-        buf[count++] = c;
-        if (c == '\n') {
-            break;
+    }
+}
+
+ssize_t SocketIO::writeZeroCopy(const char *buf, size_t len, bool *zeroCopied) {
+    *zeroCopied = true;
+    while (true) {
+        ssize_t wrote = ::send(_fd, buf, len, MSG_NOSIGNAL | MSG_ZEROCOPY);
+        if (wrote >= 0) {
+            return wrote;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        } else if (errno == ENOBUFS) {
+            *zeroCopied = false;
+            return writeSome(buf, len);
+        } else {
+            return -1;
+        }
+    }
+}
+
+int SocketIO::writeSome(const char *buf, int len) {
+    while (true) {
+        // MSG_NOSIGNAL：对端已关闭时返回EPIPE而不是产生SIGPIPE
+        int wrote = ::send(_fd, buf, len, MSG_NOSIGNAL);
+        if (wrote >= 0) {
+            return wrote;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        } else {
+            return -1;
         }
     }
-    buf[count] = '\0';
-    return count;
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
 #define _SOCKETIO_H
 
 #include <errno.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 class SocketIO {
@@ -10,9 +13,20 @@ public:
 
     int readn(char *buf, int len);
 
-    int writen(const char *buf, int len);
+    // 只调用一次send，返回写入的字节数，发送缓冲区已满时返回0，出错返回-1
+    int writeSome(const char *buf, int len);
 
-    int readLine(char *buf, int len);
+    // 一次sendmsg发送多段数据，返回值同writeSome；more为true时带MSG_MORE，告诉内核后面马上还有数据
+    ssize_t writevSome(const struct iovec *iov, int iovcnt, bool more);
+
+    // 一次sendfile，从inFd的*offset处发送最多len字节并推进*offset，返回值同writeSome
+    // 文件在len字节之前就结束时返回-1，errno为ENODATA
+    // sendfile没有MSG_NOSIGNAL，依赖EventLoop构造时忽略SIGPIPE
+    ssize_t sendFile(int inFd, off_t *offset, size_t len);
+
+    // 带MSG_ZEROCOPY的一次send，返回值同writeSome
+    // 内核无法分配完成通知(ENOBUFS)时退回普通send，*zeroCopied置为false
+    ssize_t writeZeroCopy(const char *buf, size_t len, bool *zeroCopied);
 
 private:
     int _fd;
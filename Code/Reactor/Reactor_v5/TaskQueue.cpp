@@ -1,6 +1,6 @@
 #include "TaskQueue.h"
 
-TaskQueue::TaskQueue(size_t capacity) : _capacity(capacity) {}
+TaskQueue::TaskQueue(size_t capacity) : _capacity(capacity), _lowWater(capacity / 2) {}
 
 bool TaskQueue::isFull() {
     return _queue.size() >= _capacity;
@@ -19,7 +19,19 @@ void TaskQueue::push(Task &&task) {
     _notEmpty.notify_one();
 }
 
-Task TaskQueue::pop() {
+bool TaskQueue::tryPush(Task &&task) {
+    unique_lock<mutex> ul{_mutex};
+    if (isFull()) {
+        // 在锁内置位，保证之后一定有一次pop看到它
+        _saturated = true;
+        return false;
+    }
+    _queue.push(std::move(task));
+    _notEmpty.notify_one();
+    return true;
+}
+
+Task TaskQueue::pop(bool *lowWater) {
     unique_lock<mutex> ul{_mutex};
     while (isEmpty() && _flag) {
         _notEmpty.wait(ul);
@@ -28,11 +40,20 @@ Task TaskQueue::pop() {
         Task temp = std::move(_queue.front());
         _queue.pop();
         _notFull.notify_one();
+        if (lowWater && _saturated && _queue.size() <= _lowWater) {
+            _saturated = false;
+            *lowWater = true;
+        }
         return temp;
     }
     return Task{};
 }
 
+void TaskQueue::setLowWater(size_t lowWater) {
+    unique_lock<mutex> ul{_mutex};
+    _lowWater = lowWater;
+}
+
 void TaskQueue::wakeAll() {
     _flag = false;
     _notEmpty.notify_all();
@@ -23,12 +23,21 @@ public:
 
     void push(Task &&task);
 
-    Task pop();
+    // 队列满时不等待，直接返回false，并记下队列已饱和
+    bool tryPush(Task &&task);
+
+    // lowWater不为空时，饱和后第一次降到低水位的那次pop把*lowWater置为true
+    Task pop(bool *lowWater = nullptr);
+
+    // 饱和之后队列长度降到lowWater以下才算恢复
+    void setLowWater(size_t lowWater);
 
     void wakeAll();
 
 private:
     size_t _capacity;
+    size_t _lowWater;
+    bool _saturated = false;
     queue<Task> _queue;
     mutex _mutex;
     condition_variable _notEmpty;
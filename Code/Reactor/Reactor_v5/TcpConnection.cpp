@@ -1,96 +1,729 @@
 #include "TcpConnection.h"
 #include "EventLoop.h"
+#include "Logger.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
-TcpConnection::TcpConnection(int fd, EventLoop *eventLoop)
-    : _sockIO(fd), _sock(fd), _localAddr(getLocalAddr()), _peerAddr(getPeerAddr()), _loop(eventLoop) {}
+// 输入缓冲区一开始不预留空间，第一次读时按实际数据大小分配，空闲连接几乎不占内存
+TcpConnection::TcpConnection(int fd, EventLoop *eventLoop, const InetAddress &peer)
+    : _loop(eventLoop), _callbacks(nullptr), _sock(fd), _events(EPOLLIN | EPOLLRDHUP), _pendingReplies(0), _edgeTriggered(false),
+      _peerClosed(false), _disconnected(false), _shutdownPending(false), _flushQueued(false), _localAddrResolved(false), _aboveHighWater(false),
+      _pauseOnHighWater(false), _quickAck(false), _readPaused(0), _inputBuffer(0), _outputHead(0), _outputOffset(0), _outputBytes(0),
+      _highWaterMark(0), _lowWaterMark(0), _id(0), _peerAddr(peer) {}
 
+// 每个空闲连接都有一个TcpConnection，加字段前先看能否放进ZeroCopyState这类按需分配的结构
+// 64位下目前是240字节，超过4个缓存行时编译失败
+static_assert(sizeof(void *) != 8 || sizeof(TcpConnection) <= 256, "TcpConnection grew past 256 bytes");
+
+const uint8_t TcpConnection::kPauseByOutput;
+const uint8_t TcpConnection::kPauseByUser;
+
+void TcpConnection::reset(int fd, const InetAddress &peer) {
+    _sock.reset(fd);
+    _events = EPOLLIN | EPOLLRDHUP;
+    _pendingReplies = 0;
+    _edgeTriggered = false;
+    _peerClosed = false;
+    _disconnected = false;
+    _shutdownPending = false;
+    _flushQueued = false;
+    _localAddrResolved = false;
+    _aboveHighWater = false;
+    _quickAck = false;
+    _readPaused = 0;
+    _id = 0;
+    _peerAddr = peer;
+}
+
+void TcpConnection::recycle() {
+    _sock.reset(-1);
+    clearOutput();
+    _inputBuffer.retrieveAll();
+    // 大请求撑大的输入缓冲区不跟着对象留在池里
+    if (_inputBuffer.internalCapacity() > Buffer::kExtraBufSize) {
+        _inputBuffer.shrink(0);
+    }
+    // EventLoop收齐完成通知后才回收连接，这里已经没有未确认的零拷贝发送
+    _zeroCopy.reset();
+}
+
+int TcpConnection::fd() {
+    return _sock.getFd();
+}
+
+// 数据已经由readToBuffer读入，全部交给调用者
 string TcpConnection::receive() {
-    string str;
-    char buf[256];
+    return _inputBuffer.retrieveAllAsString();
+}
+
+Buffer *TcpConnection::inputBuffer() {
+    return &_inputBuffer;
+}
+
+void TcpConnection::setEdgeTriggered() {
+    _edgeTriggered = true;
+    _events |= EPOLLET;
+}
+
+void TcpConnection::setQuickAck() {
+    _quickAck = true;
+    int opt = 1;
+    setsockopt(fd(), IPPROTO_TCP, TCP_QUICKACK, &opt, sizeof(opt));
+}
+
+uint32_t TcpConnection::getEvents() {
+    return _events;
+}
+
+int TcpConnection::readToBuffer() {
+    int total = 0;
     while (true) {
-        memset(buf, 0, 256);
-        int readSize = _sockIO.readLine(buf, 256);
-        if (readSize > 0) {
-            str += buf;
-        } else if (readSize < 0) {
-            throw "读取出错";
-        }
-        if (readSize < 256) {
+        size_t space = 0;
+        int savedErrno = 0;
+        ssize_t ret = _inputBuffer.readFd(fd(), &savedErrno, &space);
+        errno = savedErrno;
+        if (ret > 0) {
+            total += ret;
+            // 水平触发读一次即可；没有填满readv提供的空间说明内核缓冲区已经读空
+            if (!_edgeTriggered || (size_t)ret < space) {
+                break;
+            }
+        } else if (ret == 0) {
+            _peerClosed = true; // 对端关闭
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break; // 已读空
+        } else {
+            _peerClosed = true; // 其他错误视为断开
             break;
         }
     }
-    return str;
+    if (_quickAck && total > 0 && !_peerClosed) {
+        int opt = 1;
+        setsockopt(fd(), IPPROTO_TCP, TCP_QUICKACK, &opt, sizeof(opt));
+    }
+    return total;
+}
+
+int TcpConnection::appendInput(const char *data, int len) {
+    if (len <= 0) {
+        _peerClosed = true; // EOF或错误
+        return 0;
+    }
+    _inputBuffer.append(data, len);
+    if (_quickAck) {
+        int opt = 1;
+        setsockopt(fd(), IPPROTO_TCP, TCP_QUICKACK, &opt, sizeof(opt));
+    }
+    return len;
+}
+
+bool TcpConnection::hasInput() {
+    return _inputBuffer.readableBytes() > 0;
+}
+
+bool TcpConnection::peerClosed() {
+    return _peerClosed;
+}
+
+void TcpConnection::setId(ConnId id) {
+    _id = id;
+}
+
+ConnId TcpConnection::getId() {
+    return _id;
+}
+
+EventLoop *TcpConnection::getLoop() {
+    return _loop;
 }
 
 void TcpConnection::send(const string &msg) {
-    _sockIO.writen(msg.c_str(), msg.size());
+    send(string(msg));
 }
 
-void TcpConnection::setNewConnectionCallback(const functionCallback &func) {
-    _newConnection = func;
+void TcpConnection::send(string &&msg) {
+    if (_disconnected || _shutdownPending || msg.empty()) {
+        return;
+    }
+    if (_zeroCopy && _zeroCopy->threshold > 0 && msg.size() >= _zeroCopy->threshold) {
+        // 零拷贝期间内核引用这块内存，放到堆上固定住地址
+        send(BufferSlice(std::move(msg)));
+        return;
+    }
+    _outputBytes += msg.size();
+    _outputQueue.push_back(OutputChunk{std::move(msg), BufferSlice(), -1, 0, 0});
+    checkHighWater();
+    queueFlush();
+}
+
+void TcpConnection::send(const BufferSlice &slice) {
+    if (_disconnected || _shutdownPending || slice.empty()) {
+        return;
+    }
+    _outputBytes += slice.size();
+    _outputQueue.push_back(OutputChunk{string(), slice, -1, 0, 0});
+    checkHighWater();
+    queueFlush();
+}
+
+bool TcpConnection::enableZeroCopy(size_t threshold) {
+    int on = 1;
+    if (setsockopt(fd(), SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) < 0) {
+        LOG_WARN << "fd=" << fd() << " SO_ZEROCOPY: " << strerror(errno);
+        return false;
+    }
+    _zeroCopy.reset(new ZeroCopyState{threshold, 0, deque<ZeroCopyPending>()});
+    return true;
 }
 
-void TcpConnection::setMessageCallback(const functionCallback &func) {
-    _message = func;
+bool TcpConnection::reapZeroCopy() {
+    if (!_zeroCopy) {
+        return false;
+    }
+    bool reaped = false;
+    while (true) {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd(), &msg, MSG_ERRQUEUE) < 0) {
+            break; // EAGAIN：错误队列已取空
+        }
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            struct sock_extended_err *err = reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cm));
+            if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            reaped = true;
+            // [ee_info, ee_data]范围内的发送已经完成，TCP按顺序确认
+            uint32_t hi = err->ee_data;
+            deque<ZeroCopyPending> &pendings = _zeroCopy->pendings;
+            while (!pendings.empty() && (int32_t)(pendings.front().seq - hi) <= 0) {
+                pendings.pop_front();
+            }
+            if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                // 内核最终还是拷贝了(例如回环或网卡不支持)，零拷贝只剩额外开销，关掉
+                _zeroCopy->threshold = 0;
+            }
+        }
+    }
+    return reaped;
 }
 
-void TcpConnection::setCloseCallback(const functionCallback &func) {
-    _close = func;
+size_t TcpConnection::zeroCopyPending() {
+    return _zeroCopy ? _zeroCopy->pendings.size() : 0;
+}
+
+bool TcpConnection::isZeroCopyChunk(const OutputChunk &chunk) {
+    return _zeroCopy && _zeroCopy->threshold > 0 && !chunk.slice.empty() && chunk.size() >= _zeroCopy->threshold;
+}
+
+ssize_t TcpConnection::flushZeroCopy(OutputChunk &front) {
+    bool zeroCopied = false;
+    SocketIO io(fd());
+    ssize_t ret = io.writeZeroCopy(front.bytes() + _outputOffset, front.size() - _outputOffset, &zeroCopied);
+    if (ret > 0 && zeroCopied) {
+        // 每次成功的零拷贝发送占用一个序号，完成前持有缓冲区
+        _zeroCopy->pendings.push_back(ZeroCopyPending{_zeroCopy->seq++, front.slice});
+    }
+    return ret;
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t length) {
+    if (_disconnected || length == 0) {
+        return;
+    }
+    int ownedFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (ownedFd < 0) {
+        LOG_WARN << "sendFile dup fd=" << fd << ": " << strerror(errno);
+        return;
+    }
+    sendOwnedFile(ownedFd, offset, length);
+}
+
+void TcpConnection::sendOwnedFile(int ownedFd, off_t offset, size_t length) {
+    if (_disconnected || _shutdownPending) {
+        close(ownedFd);
+        return;
+    }
+    _outputBytes += length;
+    _outputQueue.push_back(OutputChunk{string(), BufferSlice(), ownedFd, offset, length});
+    checkHighWater();
+    queueFlush();
+}
+
+void TcpConnection::queueFlush() {
+    // 正在等EPOLLOUT时由handleWrite负责发送，不必登记
+    if (!_flushQueued && !(_events & EPOLLOUT)) {
+        _flushQueued = true;
+        _loop->queueFlush(shared_from_this());
+    }
+}
+
+bool TcpConnection::outputEmpty() {
+    return _outputHead == _outputQueue.size();
+}
+
+OutputChunk &TcpConnection::outputFront() {
+    return _outputQueue[_outputHead];
+}
+
+void TcpConnection::popOutput() {
+    OutputChunk &front = outputFront();
+    if (front.fileFd >= 0) {
+        close(front.fileFd);
+    }
+    front = OutputChunk(); // 立即释放消息占用的内存
+    ++_outputHead;
+    _outputOffset = 0;
+    if (outputEmpty()) {
+        // 队列空了，回到开头复用；突发流量撑大的数组还给系统
+        if (_outputQueue.capacity() > 64) {
+            vector<OutputChunk>().swap(_outputQueue);
+        } else {
+            _outputQueue.clear();
+        }
+        _outputHead = 0;
+    }
+}
+
+void TcpConnection::clearOutput() {
+    while (!outputEmpty()) {
+        popOutput();
+    }
+    _outputBytes = 0;
+}
+
+void TcpConnection::flush() {
+    _flushQueued = false;
+    if (_disconnected) {
+        clearOutput();
+        return;
+    }
+    if (sendInFlight()) {
+        return; // 完成后sendComplete接着发送
+    }
+    SocketIO io(fd());
+    struct iovec iov[IOV_MAX];
+    while (!outputEmpty()) {
+        ssize_t ret;
+        size_t batchBytes = 0;
+        OutputChunk &front = outputFront();
+        if (front.fileFd >= 0) {
+            // 文件区间：sendfile在内核中直接从页缓存发送，不经过用户态
+            batchBytes = front.fileLen;
+            ret = io.sendFile(front.fileFd, &front.fileOffset, front.fileLen);
+            if (ret > 0) {
+                front.fileLen -= ret;
+                if (front.fileLen == 0) {
+                    popOutput();
+                }
+            }
+        } else if (_asyncSend) {
+            // 完成模式：连续的内存消息交给io_uring，发送结果在sendComplete中处理
+            submitOutput();
+            return;
+        } else {
+            if (isZeroCopyChunk(front)) {
+                batchBytes = front.size() - _outputOffset;
+                ret = flushZeroCopy(front);
+            } else {
+                // 连续的普通内存消息合并成一次writev，遇到文件区间或零拷贝消息为止
+                int iovcnt = 0;
+                for (auto it = _outputQueue.begin() + _outputHead; it != _outputQueue.end() && it->fileFd < 0 && !(iovcnt > 0 && isZeroCopyChunk(*it)) && iovcnt < IOV_MAX; ++it, ++iovcnt) {
+                    size_t skip = iovcnt == 0 ? _outputOffset : 0;
+                    iov[iovcnt].iov_base = const_cast<char *>(it->bytes() + skip);
+                    iov[iovcnt].iov_len = it->size() - skip;
+                    batchBytes += iov[iovcnt].iov_len;
+                }
+                // 一批装不下整个队列时带上MSG_MORE，让内核攒满再发，避免小包
+                ret = io.writevSome(iov, iovcnt, batchBytes < _outputBytes);
+            }
+            size_t left = ret > 0 ? ret : 0;
+            while (left > 0) {
+                size_t remain = outputFront().size() - _outputOffset;
+                if (left < remain) {
+                    _outputOffset += left;
+                    break;
+                }
+                left -= remain;
+                popOutput();
+            }
+        }
+        if (ret < 0) {
+            dropOutput(errno);
+            return;
+        }
+        _outputBytes -= ret;
+        checkLowWater();
+        if ((size_t)ret < batchBytes) {
+            // 发送缓冲区满了，剩下的等EPOLLOUT
+            enableWriting();
+            return;
+        }
+    }
+    disableWriting();
+    if (_shutdownPending) {
+        ::shutdown(fd(), SHUT_WR);
+        _shutdownPending = false;
+    }
+    writeCompleteCallback();
+}
+
+void TcpConnection::dropOutput(int err) {
+    if (err == ECONNRESET || err == EPIPE) {
+        // 对端先断开是常态，连接随后由EventLoop关闭
+        LOG_DEBUG << "fd=" << fd() << " flush: " << strerror(err);
+    } else {
+        LOG_WARN << "fd=" << fd() << " flush: " << strerror(err);
+    }
+    clearOutput();
+    // 队列清空后同样要检查低水位，否则高水位时暂停的读取不会恢复
+    checkLowWater();
+    disableWriting();
+}
+
+void TcpConnection::enableAsyncSend() {
+    if (!_asyncSend) {
+        _asyncSend.reset(new AsyncSend());
+    }
+}
+
+bool TcpConnection::sendInFlight() {
+    return _asyncSend && _asyncSend->inFlight;
+}
+
+void TcpConnection::submitOutput() {
+    AsyncSend &send = *_asyncSend;
+    size_t skip = _outputOffset;
+    while (!outputEmpty() && outputFront().fileFd < 0 && send.chunks.size() < IOV_MAX) {
+        send.chunks.push_back(std::move(outputFront()));
+        popOutput();
+    }
+    // chunks不再增长之后才取地址：短字符串的数据在对象内部，移动时会跟着搬家
+    send.iov.resize(send.chunks.size());
+    for (size_t i = 0; i < send.chunks.size(); ++i) {
+        size_t off = i == 0 ? skip : 0;
+        send.iov[i].iov_base = const_cast<char *>(send.chunks[i].bytes() + off);
+        send.iov[i].iov_len = send.chunks[i].size() - off;
+    }
+    send.first = 0;
+    submitAsync();
+}
+
+void TcpConnection::submitAsync() {
+    AsyncSend &send = *_asyncSend;
+    memset(&send.msg, 0, sizeof(send.msg));
+    send.msg.msg_iov = &send.iov[send.first];
+    send.msg.msg_iovlen = send.iov.size() - send.first;
+    send.inFlight = _loop->submitSend(fd(), &send.msg);
+    if (!send.inFlight) {
+        // 提交队列满且提交失败，按发送出错处理，移出的消息和输出队列一起丢弃
+        releaseAsync();
+        dropOutput(ENOBUFS);
+    }
+}
+
+void TcpConnection::releaseAsync() {
+    AsyncSend &send = *_asyncSend;
+    if (send.chunks.capacity() > 64) {
+        vector<OutputChunk>().swap(send.chunks);
+        vector<struct iovec>().swap(send.iov);
+    } else {
+        send.chunks.clear();
+        send.iov.clear();
+    }
+    send.first = 0;
+}
+
+void TcpConnection::sendComplete(int res) {
+    AsyncSend &send = *_asyncSend;
+    send.inFlight = false;
+    if (res == -EAGAIN) {
+        res = 0; // 内核一般会等可写后自己重试，万一返回EAGAIN就当作没发出，重新提交
+    }
+    if (_disconnected || res < 0) {
+        releaseAsync();
+        if (!_disconnected) {
+            dropOutput(-res);
+        }
+        return;
+    }
+    _outputBytes -= res;
+    size_t left = res;
+    while (left > 0 && send.first < send.iov.size()) {
+        struct iovec &v = send.iov[send.first];
+        if (left < v.iov_len) {
+            v.iov_base = static_cast<char *>(v.iov_base) + left;
+            v.iov_len -= left;
+            break;
+        }
+        left -= v.iov_len;
+        ++send.first;
+    }
+    if (send.first < send.iov.size()) {
+        // 发送缓冲区满时内核只发出一部分，剩下的接着提交
+        // 先提交再检查水位，低水位回调里的send只进输出队列
+        submitAsync();
+        checkLowWater();
+        return;
+    }
+    releaseAsync();
+    checkLowWater();
+    flush();
+}
+
+void TcpConnection::handleWrite() {
+    flush();
+}
+
+size_t TcpConnection::pendingOutput() {
+    return _outputBytes;
+}
+
+void TcpConnection::shutdown() {
+    if (_disconnected || _shutdownPending) {
+        return;
+    }
+    if (_outputBytes == 0) {
+        ::shutdown(fd(), SHUT_WR);
+    } else {
+        _shutdownPending = true; // 输出队列发完后在flush中关闭写端
+    }
+}
+
+void TcpConnection::stopReading() {
+    updateReading(); // _peerClosed已经置位
+}
+
+void TcpConnection::pauseReading() {
+    _readPaused |= kPauseByUser;
+    updateReading();
+}
+
+void TcpConnection::resumeReading() {
+    _readPaused &= ~kPauseByUser;
+    updateReading();
+}
+
+void TcpConnection::resumeReadingInLoop() {
+    if (_loop) {
+        _loop->runInLoop(std::bind(&TcpConnection::resumeReading, shared_from_this()));
+    }
+}
+
+void TcpConnection::updateReading() {
+    if (_disconnected) {
+        return;
+    }
+    uint32_t events = _events;
+    if (_readPaused || _peerClosed) {
+        events &= ~(EPOLLIN | EPOLLRDHUP);
+    } else {
+        events |= EPOLLIN | EPOLLRDHUP;
+    }
+    // 重新MOD时epoll会重新检查就绪状态，边缘触发下已到达的数据也不会丢
+    if (events != _events) {
+        _events = events;
+        _loop->updateFd(fd(), _events);
+    }
+}
+
+void TcpConnection::setWaterMarks(size_t high, size_t low, bool pauseReading) {
+    _highWaterMark = high;
+    _lowWaterMark = low < high ? low : high / 2;
+    _pauseOnHighWater = pauseReading;
+}
+
+void TcpConnection::checkHighWater() {
+    if (_highWaterMark == 0 || _aboveHighWater || _outputBytes < _highWaterMark) {
+        return;
+    }
+    _aboveHighWater = true;
+    if (_pauseOnHighWater) {
+        // 对端收得慢：先别读它的新请求，否则回复会越积越多
+        _readPaused |= kPauseByOutput;
+        updateReading();
+    }
+    highWaterMarkCallback();
+}
+
+void TcpConnection::checkLowWater() {
+    if (!_aboveHighWater || _outputBytes > _lowWaterMark) {
+        return;
+    }
+    _aboveHighWater = false;
+    if (_readPaused & kPauseByOutput) {
+        _readPaused &= ~kPauseByOutput;
+        updateReading();
+    }
+    lowWaterMarkCallback();
+}
+
+bool TcpConnection::isDisconnected() {
+    return _disconnected;
+}
+
+void TcpConnection::setDisconnected() {
+    _disconnected = true;
+    clearOutput(); // 关闭还没发送的文件区间持有的fd
+}
+
+void TcpConnection::enableWriting() {
+    if (!(_events & EPOLLOUT)) {
+        _events |= EPOLLOUT;
+        _loop->updateFd(fd(), _events);
+    }
+}
+
+void TcpConnection::disableWriting() {
+    if (_events & EPOLLOUT) {
+        _events &= ~EPOLLOUT;
+        _loop->updateFd(fd(), _events);
+    }
+}
+
+void TcpConnection::setCallbacks(const ConnectionCallbacks *callbacks) {
+    _callbacks = callbacks;
 }
 
 void TcpConnection::newConnectionCallback() {
-    if (_newConnection) {
-        _newConnection(shared_from_this());
+    if (_callbacks && _callbacks->newConnection) {
+        _callbacks->newConnection(shared_from_this());
     }
 }
 
 void TcpConnection::messageCallback() {
-    if (_message) {
-        _message(shared_from_this());
+    if (_callbacks && _callbacks->message) {
+        _callbacks->message(shared_from_this());
     }
 }
 
 void TcpConnection::closeCallback() {
-    if (_close) {
-        _close(shared_from_this());
+    if (_callbacks && _callbacks->close) {
+        _callbacks->close(shared_from_this());
     }
 }
 
-string TcpConnection::toString() {
-    ostringstream oss;
-    oss << "服务端" << _localAddr.getIp() << ":" << _localAddr.getPort()
-        << "---客户端" << _peerAddr.getIp() << ":" << _peerAddr.getPort();
-    return oss.str();
+void TcpConnection::writeCompleteCallback() {
+    if (_callbacks && _callbacks->writeComplete) {
+        _callbacks->writeComplete(shared_from_this());
+    }
 }
 
-InetAddress TcpConnection::getLocalAddr() {
-    struct sockaddr_in addr;
-    socklen_t len = sizeof(struct sockaddr);
-    getsockname(_sock.getFd(), (struct sockaddr *)&addr, &len);
-    return InetAddress{addr};
+void TcpConnection::highWaterMarkCallback() {
+    if (_callbacks && _callbacks->highWaterMark) {
+        _callbacks->highWaterMark(shared_from_this());
+    }
 }
 
-InetAddress TcpConnection::getPeerAddr() {
-    struct sockaddr_in addr;
-    socklen_t len = sizeof(struct sockaddr);
-    getpeername(_sock.getFd(), (struct sockaddr *)&addr, &len);
-    return InetAddress{addr};
+void TcpConnection::lowWaterMarkCallback() {
+    if (_callbacks && _callbacks->lowWaterMark) {
+        _callbacks->lowWaterMark(shared_from_this());
+    }
+}
+
+string TcpConnection::toString() {
+    InetAddress &local = getLocalAddr();
+    string str = "服务端";
+    str += local.toIpPort();
+    str += "---客户端";
+    str += _peerAddr.toIpPort();
+    return str;
 }
 
-bool TcpConnection::isClosed() {
-    int fd = _sock.getFd();
-    char buf[1];
-    int ret = recv(fd, buf, sizeof(buf), MSG_PEEK);
-    if (ret == 0) {
-        return true; // 对端关闭
-    } else if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
-        return true; // 其他错误视为断开
+InetAddress &TcpConnection::getLocalAddr() {
+    if (!_localAddrResolved) {
+        struct sockaddr_storage addr;
+        socklen_t len = sizeof(addr);
+        getsockname(fd(), (struct sockaddr *)&addr, &len);
+        if (_localAddr) {
+            *_localAddr = InetAddress{(struct sockaddr *)&addr, len};
+        } else {
+            _localAddr.reset(new InetAddress{(struct sockaddr *)&addr, len});
+        }
+        _localAddrResolved = true;
     }
-    return false;
+    return *_localAddr;
+}
+
+InetAddress &TcpConnection::getPeerAddr() {
+    return _peerAddr;
 }
 
 void TcpConnection::sendInLoop(const string &msg) {
     if (_loop) {
-        _loop->runInLoop(std::bind(&TcpConnection::send, this, msg));
+        // 持有shared_ptr，保证任务执行时连接对象仍然存在
+        sendInLoop(string(msg));
+    }
+}
+
+void TcpConnection::sendInLoop(string &&msg) {
+    if (_loop) {
+        // 持有shared_ptr，保证任务执行时连接对象仍然存在
+        _loop->runInLoop(std::bind(&TcpConnection::sendOwned, shared_from_this(), std::move(msg)));
+    }
+}
+
+void TcpConnection::sendOwned(string &msg) {
+    send(std::move(msg));
+}
+
+void TcpConnection::expectReply() {
+    ++_pendingReplies;
+}
+
+void TcpConnection::replyInLoop(string &&msg) {
+    if (_loop) {
+        _loop->runInLoop(std::bind(&TcpConnection::replyOwned, shared_from_this(), std::move(msg)));
+    }
+}
+
+void TcpConnection::replyOwned(string &msg) {
+    if (_pendingReplies > 0) {
+        --_pendingReplies;
+    }
+    send(std::move(msg));
+    // 最后一条回复为空或已在等EPOLLOUT时也要让EventLoop检查一次能否关闭
+    if (_peerClosed && _pendingReplies == 0 && !_disconnected) {
+        queueFlush();
+    }
+}
+
+bool TcpConnection::readyToClose() {
+    return _peerClosed && _pendingReplies == 0 && pendingOutput() == 0;
+}
+
+void TcpConnection::sendInLoop(const BufferSlice &slice) {
+    if (_loop) {
+        _loop->runInLoop(std::bind(&TcpConnection::sendSlice, shared_from_this(), slice));
+    }
+}
+
+void TcpConnection::sendSlice(const BufferSlice &slice) {
+    send(slice);
+}
+
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t length) {
+    if (!_loop || length == 0) {
+        return;
+    }
+    // 先dup一份，调用者返回后就可以关闭自己的fd
+    int ownedFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (ownedFd < 0) {
+        LOG_WARN << "sendFileInLoop dup fd=" << fd << ": " << strerror(errno);
+        return;
     }
+    _loop->runInLoop(std::bind(&TcpConnection::sendOwnedFile, shared_from_this(), ownedFd, offset, length));
 }
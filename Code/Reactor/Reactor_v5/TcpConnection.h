@@ -1,38 +1,206 @@
 #ifndef _TCPCONNECTION_H
 #define _TCPCONNECTION_H
 
+#include "Buffer.h"
+#include "BufferSlice.h"
+#include "ConnectionTable.h"
 #include "InetAddress.h"
 #include "Socket.h"
 #include "SocketIO.h"
 #include <cstring>
+#include <deque>
 #include <functional>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <sys/epoll.h>
 
-using std::ostringstream;
+using std::deque;
 using std::shared_ptr;
 using std::string;
+using std::unique_ptr;
+using std::vector;
 
 class EventLoop;
+struct ConnectionCallbacks;
+
+// 输出队列中的一段：内存中的消息，或者文件中的一段区间
+struct OutputChunk {
+    string data;
+    BufferSlice slice;               // 非空时消息在这里，多个连接可以共享，地址在零拷贝完成前保持不变
+    int fileFd;                      // -1表示内存消息，否则为连接持有的dup出来的fd
+    off_t fileOffset;                // 文件中下一个要发送的位置
+    size_t fileLen;                  // 文件区间中还没发送的字节数
+
+    const char *bytes() const {
+        return slice.empty() ? data.data() : slice.data();
+    }
+
+    size_t size() const {
+        return slice.empty() ? data.size() : slice.size();
+    }
+};
+
+// 一次MSG_ZEROCOPY发送：内核确认序号seq完成之前，buf不能释放
+struct ZeroCopyPending {
+    uint32_t seq;
+    BufferSlice buf;
+};
+
+// 零拷贝相关的状态，只有开启零拷贝的连接才分配
+struct ZeroCopyState {
+    size_t threshold; // 0表示内核已退回拷贝，不再使用零拷贝
+    uint32_t seq;     // 下一次零拷贝发送的序号，与内核的计数一致
+    deque<ZeroCopyPending> pendings;
+};
+
+// io_uring完成模式下提交的一次发送：消息从输出队列移到这里，完成之前内核引用着数据和iov
+// 只有完成模式的连接才分配
+struct AsyncSend {
+    vector<OutputChunk> chunks;
+    vector<struct iovec> iov;
+    size_t first; // iov中第一段还没发完的下标
+    struct msghdr msg;
+    bool inFlight;
+};
 
 class TcpConnection : public std::enable_shared_from_this<TcpConnection> {
 public:
     using functionCallback = std::function<void(const shared_ptr<TcpConnection> &)>;
 
-    explicit TcpConnection(int fd, EventLoop *eventLoop);
+    // fd由Acceptor以非阻塞方式accept，发送不完的数据放入输出缓冲区
+    // peer为accept时得到的对端地址，本端地址在第一次用到时才获取
+    TcpConnection(int fd, EventLoop *eventLoop, const InetAddress &peer);
 
+    // 从ConnectionPool取出后复用：接管新的fd，状态回到刚构造时
+    void reset(int fd, const InetAddress &peer);
+
+    // 放回ConnectionPool前调用：关闭fd，清空缓冲区，过大的缓冲区还给系统
+    void recycle();
+
+    // 取出输入缓冲区中的全部数据
     string receive();
 
+    // 输入缓冲区，可以直接在其中查找、解析后再retrieve，避免拷贝
+    Buffer *inputBuffer();
+
+    // 边缘触发模式：可读时一次性读到EAGAIN
+    void setEdgeTriggered();
+
+    // 每次读到数据后设置TCP_QUICKACK，内核在发出ACK后会自动清除它
+    void setQuickAck();
+
+    // 当前向epoll注册的事件
+    uint32_t getEvents();
+
+    // 完成模式下recv读到的数据，len不大于0表示对端关闭或出错，返回追加的字节数
+    int appendInput(const char *data, int len);
+
+    // 用readv把数据读入_inputBuffer，返回本次读到的字节数
+    // 水平触发只读一次，边缘触发读到内核缓冲区为空
+    int readToBuffer();
+
+    bool hasInput();
+
+    // readToBuffer时是否读到了EOF或错误，这是判断对端关闭的唯一依据
+    bool peerClosed();
+
+    // 对端已半关闭但还有回复没发完：不再关注可读，等发完再关闭连接
+    void stopReading();
+
+    // 只能在所属EventLoop线程调用：消息交给其他线程处理之前调用，表示之后会有一条replyInLoop
+    // 对端半关闭(shutdown(SHUT_WR))后，连接要等所有预告的回复都发完才关闭，而不只是看输出队列是否为空
+    void expectReply();
+
+    // 可以在任意线程调用：发送回复并结束一次expectReply，msg为空时只结束
+    void replyInLoop(string &&msg);
+
+    // 对端已半关闭，预告的回复都已到达并且输出队列已发完，可以关闭连接
+    bool readyToClose();
+
+    // 暂停/恢复读取(epoll_ctl MOD去掉或加回EPOLLIN)，用于上游处理不过来时的反压
+    // 只能在所属EventLoop线程调用，与高水位触发的暂停互不影响
+    void pauseReading();
+
+    void resumeReading();
+
+    // 可以在任意线程调用
+    void resumeReadingInLoop();
+
+    // 输出队列积压到high字节时调用高水位回调，pauseReading为true时同时暂停读取，
+    // 发送到不超过low字节时恢复读取并调用低水位回调；high为0表示不限制
+    void setWaterMarks(size_t high, size_t low, bool pauseReading);
+
+    // 连接在所属EventLoop连接表中的编号
+    void setId(ConnId id);
+
+    ConnId getId();
+
+    // 连接所属的EventLoop
+    EventLoop *getLoop();
+
+    // 只能在所属EventLoop线程调用：消息追加到输出队列，
+    // 本轮事件处理完后由EventLoop统一flush，多条回复合并成一次writev
     void send(const string &msg);
 
-    string toString();
+    void send(string &&msg);
+
+    // 发送共享的只读片段，只增加引用计数不拷贝数据
+    // 开启零拷贝时连接一直持有slice，直到内核确认发送完成
+    void send(const BufferSlice &slice);
+
+    // 开启MSG_ZEROCOPY：不小于threshold字节的消息由内核直接引用用户内存发送
+    // 内核不支持时返回false，连接继续使用普通发送
+    bool enableZeroCopy(size_t threshold);
+
+    // EPOLLERR时调用：从错误队列中取出零拷贝完成通知，释放已完成的缓冲区
+    // 取到了完成通知返回true，此时EPOLLERR不代表连接出错
+    bool reapZeroCopy();
+
+    // 还在等待内核完成通知的零拷贝发送次数
+    size_t zeroCopyPending();
+
+    // 只能在所属EventLoop线程调用：把fd中[offset, offset + length)排进输出队列，
+    // 与send的消息保持先后顺序，轮到时用sendfile发送，发送缓冲区满时等EPOLLOUT继续
+    // 连接会dup一份fd，调用者可以随时关闭自己的fd
+    void sendFile(int fd, off_t offset, size_t length);
+
+    // io_uring完成模式：内存消息不再直接writev，而是交给EventLoop的Poller，和本轮的等待一起提交
+    void enableAsyncSend();
 
-    void setNewConnectionCallback(const functionCallback &func);
+    // 提交的发送完成，res为发出的字节数或-errno；没发完的部分接着提交，发完后继续flush
+    void sendComplete(int res);
 
-    void setMessageCallback(const functionCallback &func);
+    // 有发送还没完成，内核仍在引用输出数据
+    bool sendInFlight();
 
-    void setCloseCallback(const functionCallback &func);
+    // 用writev发送输出队列，每次最多IOV_MAX段；发不完时关注EPOLLOUT，发完后取消
+    // 完成模式下已有发送在进行时直接返回，由sendComplete接着发送
+    void flush();
+
+    // 可写事件：继续发送输出队列
+    void handleWrite();
+
+    // 输出队列中等待发送的字节数
+    size_t pendingOutput();
+
+    // 主动半关闭：输出队列发完后shutdown(SHUT_WR)，之后的send直接丢弃
+    // 对端读到EOF后关闭连接，本端读到0时由EventLoop完成关闭
+    void shutdown();
+
+    // 连接已关闭，之后的send直接丢弃
+    // 未确认的零拷贝发送继续持有缓冲区，EventLoop收齐完成通知后才移除连接
+    void setDisconnected();
+
+    bool isDisconnected();
+
+    // 本端地址和对端地址，第一次调用时要getsockname，不要在每个连接都会走的路径上用
+    string toString();
+
+    // 对端地址来自accept，不需要系统调用
+    InetAddress &getPeerAddr();
+
+    // 回调表归EventLoop所有，同一个EventLoop上的连接共享一份
+    void setCallbacks(const ConnectionCallbacks *callbacks);
 
     void newConnectionCallback();
 
@@ -40,24 +208,113 @@ public:
 
     void closeCallback();
 
-    bool isClosed();
+    // 数据全部写入内核后调用
+    void writeCompleteCallback();
+
+    void highWaterMarkCallback();
+
+    void lowWaterMarkCallback();
 
     // 线程池使用TcpConnection的对象发送数据给EventLoop
     void sendInLoop(const string &msg);
 
+    void sendInLoop(string &&msg);
+
+    void sendInLoop(const BufferSlice &slice);
+
+    // 线程池中发送文件，见sendFile
+    void sendFileInLoop(int fd, off_t offset, size_t length);
+
 private:
-    SocketIO _sockIO;
-    Socket _sock;
-    InetAddress _localAddr;
-    InetAddress _peerAddr;
+    // 每次事件都会用到的字段放在前面，很少用到的放在最后
+    // 只是排列顺序，不保证落在同一个缓存行里，对象大小由TcpConnection.cpp中的static_assert约束
     EventLoop *_loop;
+    const ConnectionCallbacks *_callbacks;
+    Socket _sock; // 读写时临时构造SocketIO，不再各持一份fd
+    uint32_t _events;
+    uint32_t _pendingReplies; // expectReply之后还没到达的回复数
+    bool _edgeTriggered;
+    bool _peerClosed;
+    bool _disconnected;
+    bool _shutdownPending;
+    bool _flushQueued; // 已登记到EventLoop的待flush列表
+    bool _localAddrResolved;
+    bool _aboveHighWater;   // 已触发高水位，还没降到低水位
+    bool _pauseOnHighWater;
+    bool _quickAck;
+    uint8_t _readPaused;    // 暂停读取的原因，见kPauseBy*
+    Buffer _inputBuffer;
+    vector<OutputChunk> _outputQueue; // 待发送的消息和文件区间，[_outputHead, size())按顺序发送
+    size_t _outputHead;
+    size_t _outputOffset; // 队首内存消息已经发出的字节数
+    size_t _outputBytes;  // 队列中还没发出的总字节数
+    size_t _highWaterMark;
+    size_t _lowWaterMark;
+
+    // 很少用到的字段
+    ConnId _id;
+    InetAddress _peerAddr;
+    unique_ptr<InetAddress> _localAddr;   // 第一次用到时才getsockname，复用时保留分配
+    unique_ptr<ZeroCopyState> _zeroCopy;  // 开启零拷贝时才分配
+    unique_ptr<AsyncSend> _asyncSend;     // io_uring完成模式才分配
+
+    static const uint8_t kPauseByOutput = 1; // 输出队列超过高水位
+    static const uint8_t kPauseByUser = 2;   // pauseReading()
+
+    int fd();
+
+    // 按暂停原因和半关闭状态更新EPOLLIN
+    void updateReading();
+
+    // _outputBytes增加/减少之后检查水位
+    void checkHighWater();
+
+    void checkLowWater();
+
+    bool outputEmpty();
+
+    OutputChunk &outputFront();
+
+    void enableWriting();
+
+    void disableWriting();
+
+    // 供sendInLoop绑定，把任务里保存的消息移动进输出队列
+    void sendOwned(string &msg);
+
+    void replyOwned(string &msg);
+
+    void sendSlice(const BufferSlice &slice);
+
+    // 排入一段文件，ownedFd归连接所有，发完或断开时关闭
+    void sendOwnedFile(int ownedFd, off_t offset, size_t length);
+
+    // 输出队列有了新数据，登记到EventLoop等待本轮flush
+    void queueFlush();
+
+    // 弹出队首，文件区间同时关闭其fd
+    void popOutput();
+
+    void clearOutput();
+
+    bool isZeroCopyChunk(const OutputChunk &chunk);
+
+    // 用MSG_ZEROCOPY发送队首消息，返回值同writeSome
+    ssize_t flushZeroCopy(OutputChunk &front);
+
+    // 把队首连续的内存消息(最多IOV_MAX段)移进_asyncSend并提交
+    void submitOutput();
+
+    // 提交_asyncSend中还没发完的部分
+    void submitAsync();
+
+    // 发送完成或被丢弃后清空_asyncSend，突发流量撑大的数组还给系统
+    void releaseAsync();
 
-    functionCallback _newConnection;
-    functionCallback _message;
-    functionCallback _close;
+    // 发送出错：丢弃输出队列，见flush
+    void dropOutput(int err);
 
-    InetAddress getLocalAddr();
-    InetAddress getPeerAddr();
+    InetAddress &getLocalAddr();
 };
 
 #endif //_TCPCONNECTION_H
\ No newline at end of file
@@ -1,19 +1,198 @@
 #include "TcpServer.h"
+#include "TcpConnection.h"
+#include "Logger.h"
+#include <algorithm>
+#include <pthread.h>
 
-TcpServer::TcpServer(const string &ip, unsigned short port, size_t maxEvents)
-    : _acceptor(ip, port), _eventLoop(_acceptor, maxEvents) {}
+TcpServer::TcpServer(const string &ip, unsigned short port, size_t maxEvents, size_t ioThreadNum, PollerType pollerType,
+                     const SocketOptions &sockOpts)
+    : TcpServer(InetAddress(ip, port), maxEvents, ioThreadNum, pollerType, sockOpts) {}
+
+TcpServer::TcpServer(const InetAddress &listenAddr, size_t maxEvents, size_t ioThreadNum, PollerType pollerType,
+                     const SocketOptions &sockOpts)
+    : _listenAddr(listenAddr), _sockOpts(sockOpts), _acceptor(listenAddr), _eventLoop(_acceptor, maxEvents, pollerType), _loopPool(ioThreadNum, maxEvents, pollerType),
+      _edgeTriggered(false), _busyPollSpin(0), _sockBusyPollUs(0), _zeroCopyThreshold(0), _poolCapacity(0), _poolTrimInterval(0), _reusePortShards(false), _cpuSteering(false) {
+    _acceptor.setSocketOptions(_sockOpts);
+}
 
 void TcpServer::start() {
+    if (_reusePortShards && _listenAddr.family() == AF_UNIX) {
+        // 同一路径只能bind一次，退回主Reactor accept后分发
+        LOG_WARN << "Unix域套接字不支持SO_REUSEPORT分片";
+        _reusePortShards = false;
+    }
+    if (_reusePortShards) {
+        _loopPool.setReusePort(_listenAddr, _acceptor.getBacklog(), _sockOpts, _cpuSteering);
+    }
+    bool quickAck = _sockOpts.quickAck && _listenAddr.family() != AF_UNIX;
+    // 每个子Reactor都持有一份回调
+    for (EventLoop *loop : _loopPool.getAllLoops()) {
+        loop->setNewConnectionCallback(functionCallback(_newConnection));
+        loop->setMessageCallback(functionCallback(_message));
+        loop->setCloseCallback(functionCallback(_close));
+        loop->setWriteCompleteCallback(functionCallback(_writeComplete));
+        loop->setHighWaterMarkCallback(functionCallback(_highWaterMark));
+        loop->setLowWaterMarkCallback(functionCallback(_lowWaterMark));
+        loop->setWaterMarks(_waterMarks);
+        if (_codec) {
+            loop->setCodec(_codec, FrameCallback(_frame));
+        }
+        loop->setEdgeTriggered(_edgeTriggered);
+        loop->setBusyPoll(_busyPollSpin, _sockBusyPollUs);
+        loop->setZeroCopy(_zeroCopyThreshold);
+        loop->setQuickAck(quickAck);
+        loop->setConnectionPool(_poolCapacity, _poolTrimInterval);
+    }
+    _eventLoop.setNewConnectionCallback(std::move(_newConnection));
+    _eventLoop.setMessageCallback(std::move(_message));
+    _eventLoop.setCloseCallback(std::move(_close));
+    _eventLoop.setWriteCompleteCallback(std::move(_writeComplete));
+    _eventLoop.setHighWaterMarkCallback(std::move(_highWaterMark));
+    _eventLoop.setLowWaterMarkCallback(std::move(_lowWaterMark));
+    _eventLoop.setWaterMarks(_waterMarks);
+    if (_codec) {
+        _eventLoop.setCodec(_codec, std::move(_frame));
+    }
+    _eventLoop.setEdgeTriggered(_edgeTriggered);
+    _eventLoop.setBusyPoll(_busyPollSpin, _sockBusyPollUs);
+    _eventLoop.setZeroCopy(_zeroCopyThreshold);
+    _eventLoop.setQuickAck(quickAck);
+    _eventLoop.setConnectionPool(_poolCapacity, _poolTrimInterval);
+    if (!_reusePortShards) {
+        _eventLoop.setThreadPool(&_loopPool);
+    }
+
+    // 分片模式下子Reactor先listen，组内序号为0..N-1，主Reactor为N
+    _loopPool.start();
     _acceptor.ready();
+    if (_reusePortShards && _cpuSteering) {
+        // 按各线程实际绑定的CPU生成映射表，组内序号i对应cpus[i]
+        vector<int> cpus = _loopPool.getCpus();
+        unsigned groupSize = _loopPool.size() + 1;
+        unsigned cpuNum = std::thread::hardware_concurrency();
+        int mainCpu = -1;
+        if (cpuNum > 0) {
+            mainCpu = _loopPool.size() % cpuNum;
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(mainCpu, &cpuSet);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        }
+        cpus.push_back(mainCpu);
+        if (cpuNum > groupSize) {
+            LOG_WARN << "CPU数" << cpuNum << "多于监听线程数" << groupSize
+                     << "，没有线程绑定的CPU上收到的连接会交给其他CPU上的线程";
+        }
+        _acceptor.attachReusePortCpuSteering(cpus);
+    }
     _eventLoop.loop();
 }
 
 void TcpServer::stop() {
     _eventLoop.unLoop();
+    _loopPool.stop();
 }
 
 void TcpServer::setAllCallback(functionCallback &&newConn, functionCallback &&msg, functionCallback &&close) {
-    _eventLoop.setNewConnectionCallback(std::move(newConn));
-    _eventLoop.setMessageCallback(std::move(msg));
-    _eventLoop.setCloseCallback(std::move(close));
-}
\ No newline at end of file
+    _newConnection = std::move(newConn);
+    _message = std::move(msg);
+    _close = std::move(close);
+}
+
+void TcpServer::setWriteCompleteCallback(functionCallback &&writeComplete) {
+    _writeComplete = std::move(writeComplete);
+}
+
+void TcpServer::setWaterMarks(size_t high, size_t low, bool pauseReading) {
+    _waterMarks.high = high;
+    _waterMarks.low = low;
+    _waterMarks.pauseReading = pauseReading;
+}
+
+void TcpServer::setWaterMarkCallbacks(functionCallback &&highWater, functionCallback &&lowWater) {
+    _highWaterMark = std::move(highWater);
+    _lowWaterMark = std::move(lowWater);
+}
+
+void TcpServer::setCodec(const shared_ptr<Codec> &codec, FrameCallback &&frameCallback) {
+    _codec = codec;
+    _frame = std::move(frameCallback);
+}
+
+void TcpServer::broadcast(const vector<shared_ptr<TcpConnection>> &conns, const BufferSlice &payload) {
+    vector<EventLoop *> loops = _loopPool.getAllLoops();
+    loops.push_back(&_eventLoop);
+    vector<vector<shared_ptr<TcpConnection>>> groups(loops.size());
+    for (const shared_ptr<TcpConnection> &conn : conns) {
+        // EventLoop只有几个，线性查找比哈希更快
+        size_t i = std::find(loops.begin(), loops.end(), conn->getLoop()) - loops.begin();
+        if (i < loops.size()) {
+            groups[i].push_back(conn);
+        }
+    }
+    for (size_t i = 0; i < loops.size(); ++i) {
+        if (!groups[i].empty()) {
+            loops[i]->broadcast(std::move(groups[i]), payload);
+        }
+    }
+}
+
+void TcpServer::broadcastAll(const BufferSlice &payload) {
+    _eventLoop.broadcastAll(payload);
+    for (EventLoop *loop : _loopPool.getAllLoops()) {
+        loop->broadcastAll(payload);
+    }
+}
+
+void TcpServer::setBacklog(int backlog) {
+    _acceptor.setBacklog(backlog);
+}
+
+void TcpServer::setReusePortShards(bool on, bool cpuSteering) {
+    _reusePortShards = on;
+    _cpuSteering = cpuSteering;
+}
+
+void TcpServer::setLoadBalance(LoadBalance strategy) {
+    _loopPool.setLoadBalance(strategy);
+}
+
+void TcpServer::setEdgeTriggered(bool on) {
+    _edgeTriggered = on;
+}
+
+void TcpServer::setBusyPoll(Interval spin, int sockBusyPollUs) {
+    _busyPollSpin = spin;
+    _sockBusyPollUs = sockBusyPollUs;
+}
+
+void TcpServer::setConnectionPool(size_t capacity, Interval trimInterval) {
+    _poolCapacity = capacity;
+    _poolTrimInterval = trimInterval;
+}
+
+void TcpServer::setZeroCopy(size_t threshold) {
+    _zeroCopyThreshold = threshold;
+}
+
+vector<LoopStatsSnapshot> TcpServer::getLoopStats() {
+    vector<LoopStatsSnapshot> stats;
+    stats.push_back(_eventLoop.getStats());
+    for (EventLoop *loop : _loopPool.getAllLoops()) {
+        stats.push_back(loop->getStats());
+    }
+    return stats;
+}
+
+BusyPollStats TcpServer::getBusyPollStats() {
+    vector<EventLoop *> loops = _loopPool.getAllLoops();
+    loops.push_back(&_eventLoop);
+    BusyPollStats total;
+    for (EventLoop *loop : loops) {
+        BusyPollStats stats = loop->getBusyPollStats();
+        total.spinPolls += stats.spinPolls;
+        total.spinWakeups += stats.spinWakeups;
+        total.sleepWakeups += stats.sleepWakeups;
+    }
+    return total;
+}
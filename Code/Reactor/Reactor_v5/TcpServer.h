@@ -3,13 +3,22 @@
 
 #include "Acceptor.h"
 #include "EventLoop.h"
+#include "EventLoopThreadPool.h"
 #include <string>
 
 using std::string;
 
 class TcpServer {
 public:
-    TcpServer(const string &ip, unsigned short port, size_t maxEvents);
+    // ioThreadNum为0时是单Reactor，大于0时主Reactor只accept，连接交给ioThreadNum个子Reactor
+    // pollerType选择IO多路复用后端，默认epoll
+    // sockOpts设置在监听套接字上，由所有新连接继承，默认只开启TCP_NODELAY
+    TcpServer(const string &ip, unsigned short port, size_t maxEvents, size_t ioThreadNum = 0,
+              PollerType pollerType = PollerType::Epoll, const SocketOptions &sockOpts = SocketOptions());
+
+    // 监听任意地址族：IPv6见InetAddress(ip, port)，Unix域见InetAddress::unixPath
+    TcpServer(const InetAddress &listenAddr, size_t maxEvents, size_t ioThreadNum = 0,
+              PollerType pollerType = PollerType::Epoll, const SocketOptions &sockOpts = SocketOptions());
 
     void start();
 
@@ -17,9 +26,79 @@ public:
 
     void setAllCallback(functionCallback &&newConn, functionCallback &&msg, functionCallback &&close);
 
+    // 连接的输出缓冲区全部写入内核后调用
+    void setWriteCompleteCallback(functionCallback &&writeComplete);
+
+    // 输出队列积压超过high字节时调用highWater，pauseReading为true时暂停读取该连接，
+    // 降到low字节以下时恢复读取并调用lowWater，用来限制慢速客户端占用的内存
+    void setWaterMarks(size_t high, size_t low, bool pauseReading = true);
+
+    void setWaterMarkCallbacks(functionCallback &&highWater, functionCallback &&lowWater);
+
+    // 在start()之前调用：由codec切帧，每个完整的帧调用一次frameCallback，取代消息回调
+    void setCodec(const shared_ptr<Codec> &codec, FrameCallback &&frameCallback);
+
+    // 把payload发给conns中的连接，可以在任意线程调用
+    // 按所属EventLoop分组，每个EventLoop只转交一次任务，所有连接共享同一份payload
+    void broadcast(const vector<shared_ptr<TcpConnection>> &conns, const BufferSlice &payload);
+
+    // 把payload发给所有连接，每个EventLoop一次转交
+    void broadcastAll(const BufferSlice &payload);
+
+    // 新连接分发给子Reactor的策略，默认轮询
+    void setLoadBalance(LoadBalance strategy);
+
+    // 监听队列长度，默认SOMAXCONN
+    void setBacklog(int backlog);
+
+    // SO_REUSEPORT分片模式：主Reactor和每个子Reactor各自监听ip:port，独立accept并处理自己的连接
+    // 由内核在各监听套接字间分配新连接，没有跨线程转交；cpuSteering为true时各线程绑定CPU，
+    // 并按实际的绑定关系挂上BPF程序，让连接落到绑定在收到它的CPU上的那个线程
+    // 线程数(ioThreadNum + 1)少于CPU数时，其余CPU上的连接没有局部性；Unix域套接字不支持，忽略
+    void setReusePortShards(bool on, bool cpuSteering = false);
+
+    // 连接使用边缘触发+非阻塞IO，默认水平触发
+    void setEdgeTriggered(bool on);
+
+    // 所有EventLoop开启自旋等待，见EventLoop::setBusyPoll
+    void setBusyPoll(Interval spin, int sockBusyPollUs = 0);
+
+    // 每个EventLoop回收已关闭的连接对象，见EventLoop::setConnectionPool
+    void setConnectionPool(size_t capacity, Interval trimInterval = std::chrono::seconds(1));
+
+    // 新连接开启MSG_ZEROCOPY，不小于threshold字节的回复零拷贝发送，0表示关闭
+    // 适合兆字节级别的大块回复，小消息的完成通知开销反而比拷贝大
+    void setZeroCopy(size_t threshold);
+
+    // 所有EventLoop的自旋统计之和
+    BusyPollStats getBusyPollStats();
+
+    // 各EventLoop的运行统计，第一个为主Reactor，可以在任意线程调用
+    vector<LoopStatsSnapshot> getLoopStats();
+
 private:
+    InetAddress _listenAddr;
+    SocketOptions _sockOpts;
     Acceptor _acceptor;
     EventLoop _eventLoop;
+    EventLoopThreadPool _loopPool;
+    functionCallback _newConnection;
+    functionCallback _message;
+    functionCallback _close;
+    functionCallback _writeComplete;
+    functionCallback _highWaterMark;
+    functionCallback _lowWaterMark;
+    WaterMarks _waterMarks;
+    shared_ptr<Codec> _codec;
+    FrameCallback _frame;
+    bool _edgeTriggered;
+    Interval _busyPollSpin;
+    int _sockBusyPollUs;
+    size_t _zeroCopyThreshold;
+    size_t _poolCapacity;
+    Interval _poolTrimInterval;
+    bool _reusePortShards;
+    bool _cpuSteering;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -28,13 +28,29 @@ void ThreadPool::addTask(Task &&task) {
     }
 }
 
+bool ThreadPool::tryAddTask(Task &&task) {
+    if (!task) {
+        return true;
+    }
+    return _taskQueue.tryPush(std::move(task));
+}
+
+void ThreadPool::setLowWaterCallback(size_t lowWater, std::function<void()> &&callback) {
+    _taskQueue.setLowWater(lowWater);
+    _lowWaterCallback = std::move(callback);
+}
+
 Task ThreadPool::getTask() {
     return _taskQueue.pop();
 }
 
 void ThreadPool::doTask() {
     while (_isAlive) {
-        Task task = getTask();
+        bool lowWater = false;
+        Task task = _taskQueue.pop(&lowWater);
+        if (lowWater && _lowWaterCallback) {
+            _lowWaterCallback();
+        }
         if (task && _isAlive) {
             task();
         }
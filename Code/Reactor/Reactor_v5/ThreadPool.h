@@ -19,6 +19,12 @@ public:
 
     void addTask(Task &&task);
 
+    // 队列满时不阻塞，返回false；之后队列降到低水位时调用低水位回调
+    bool tryAddTask(Task &&task);
+
+    // 在start()之前调用，回调在工作线程中执行
+    void setLowWaterCallback(size_t lowWater, std::function<void()> &&callback);
+
     Task getTask();
 
     void doTask();
@@ -29,6 +35,7 @@ private:
     vector<thread> _threads;
     size_t _queueSize;
     bool _isAlive = true;
+    std::function<void()> _lowWaterCallback;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "TimerQueue.h"
+#include "Logger.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+TimerQueue::TimerQueue() : _timerFd(createTimerFd()) {}
+
+TimerQueue::~TimerQueue() {
+    close(_timerFd);
+}
+
+int TimerQueue::createTimerFd() {
+    // steady_clock在Linux上即CLOCK_MONOTONIC
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR << "timerfd_create: " << strerror(errno);
+    }
+    return fd;
+}
+
+int TimerQueue::fd() {
+    return _timerFd;
+}
+
+void TimerQueue::addTimer(TimerId id, Timestamp when, Interval interval, TimerCallback &&cb) {
+    Timer timer;
+    timer.callback = std::move(cb);
+    timer.when = when;
+    timer.interval = interval;
+    _timers[id] = std::move(timer);
+    _heap.push(Entry{when, id});
+    if (_armedAt == Timestamp{} || when < _armedAt) {
+        resetTimerFd();
+    }
+}
+
+void TimerQueue::cancel(TimerId id) {
+    if (_timers.erase(id)) {
+        compact();
+    }
+}
+
+void TimerQueue::handleRead() {
+    uint64_t howMany;
+    ssize_t ret = read(_timerFd, &howMany, sizeof(howMany));
+    if (ret != sizeof(howMany) && errno != EAGAIN) {
+        LOG_ERROR << "timerfd read: " << strerror(errno);
+    }
+    _armedAt = Timestamp{};
+
+    Timestamp now = std::chrono::steady_clock::now();
+    while (!_heap.empty() && _heap.top().when <= now) {
+        Entry entry = _heap.top();
+        _heap.pop();
+        auto it = _timers.find(entry.id);
+        if (it == _timers.end() || it->second.when != entry.when) {
+            continue; // 已取消
+        }
+        // 回调中可能取消自己或添加新定时器，先把回调移出来再执行
+        TimerCallback cb = std::move(it->second.callback);
+        Interval interval = it->second.interval;
+        if (interval.count() == 0) {
+            _timers.erase(it);
+            cb();
+            continue;
+        }
+        cb();
+        it = _timers.find(entry.id);
+        if (it != _timers.end()) {
+            it->second.callback = std::move(cb);
+            it->second.when = entry.when + interval;
+            if (it->second.when < now) {
+                it->second.when = now + interval; // 落后太多时不补执行
+            }
+            _heap.push(Entry{it->second.when, entry.id});
+        }
+    }
+    resetTimerFd();
+}
+
+size_t TimerQueue::size() {
+    return _timers.size();
+}
+
+void TimerQueue::dropCancelled() {
+    while (!_heap.empty()) {
+        auto it = _timers.find(_heap.top().id);
+        if (it != _timers.end() && it->second.when == _heap.top().when) {
+            break;
+        }
+        _heap.pop();
+    }
+}
+
+void TimerQueue::compact() {
+    if (_heap.size() < 1024 || _heap.size() < 2 * _timers.size()) {
+        return;
+    }
+    vector<Entry> entries;
+    entries.reserve(_timers.size());
+    for (auto &kv : _timers) {
+        entries.push_back(Entry{kv.second.when, kv.first});
+    }
+    _heap = priority_queue<Entry, vector<Entry>, std::greater<Entry>>(std::greater<Entry>(), std::move(entries));
+}
+
+void TimerQueue::resetTimerFd() {
+    dropCancelled();
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (_heap.empty()) {
+        _armedAt = Timestamp{};
+        timerfd_settime(_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr); // 停止计时
+        return;
+    }
+    _armedAt = _heap.top().when;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(_armedAt.time_since_epoch()).count();
+    if (ns <= 0) {
+        ns = 1; // 全0表示停止计时
+    }
+    spec.it_value.tv_sec = ns / 1000000000;
+    spec.it_value.tv_nsec = ns % 1000000000;
+    if (timerfd_settime(_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        LOG_ERROR << "timerfd_settime: " << strerror(errno);
+    }
+}
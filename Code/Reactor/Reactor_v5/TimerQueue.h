@@ -0,0 +1,75 @@
+#ifndef _TIMER_QUEUE_H
+#define _TIMER_QUEUE_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <sys/timerfd.h>
+#include <unordered_map>
+#include <vector>
+
+using std::priority_queue;
+using std::unordered_map;
+using std::vector;
+
+using TimerId = uint64_t;
+using TimerCallback = std::function<void()>;
+using Timestamp = std::chrono::steady_clock::time_point;
+using Interval = std::chrono::microseconds;
+
+// 基于timerfd的定时器队列，作为一个普通的fd注册到EventLoop的epoll中
+// 到期时间用最小堆管理，取消时只从表中删除，堆中的过期项在弹出时跳过
+// 除构造函数外，所有成员函数都只能在所属EventLoop线程中调用
+class TimerQueue {
+public:
+    TimerQueue();
+
+    ~TimerQueue();
+
+    int fd();
+
+    // interval为0表示一次性定时器，否则每隔interval重复执行
+    void addTimer(TimerId id, Timestamp when, Interval interval, TimerCallback &&cb);
+
+    void cancel(TimerId id);
+
+    // timerfd可读时调用，执行所有已到期的定时器
+    void handleRead();
+
+    size_t size();
+
+private:
+    struct Timer {
+        TimerCallback callback;
+        Timestamp when;
+        Interval interval;
+    };
+
+    struct Entry {
+        Timestamp when;
+        TimerId id;
+
+        bool operator>(const Entry &rhs) const {
+            return when > rhs.when || (when == rhs.when && id > rhs.id);
+        }
+    };
+
+    int _timerFd;
+    priority_queue<Entry, vector<Entry>, std::greater<Entry>> _heap;
+    unordered_map<TimerId, Timer> _timers;
+    Timestamp _armedAt; // timerfd当前设置的到期时间，未设置时为默认值
+
+    int createTimerFd();
+
+    // 丢弃堆顶已取消的定时器
+    void dropCancelled();
+
+    // 已取消的项过多时重建堆，防止反复取消的定时器撑大堆
+    void compact();
+
+    // 按堆顶的到期时间重新设置timerfd
+    void resetTimerFd();
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef _BENCH_UTIL_H
+#define _BENCH_UTIL_H
+
+// 各基准共用的小工具：计时、建立回环连接、统计分位数
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace bench {
+
+inline double nowSec() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 已排好序的样本的分位数，p取值0~1
+inline double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t i = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+    return sorted[i];
+}
+
+// 阻塞地连接127.0.0.1:port，服务端线程可能还没listen，失败时重试一会儿
+inline int connectTcp(unsigned short port, bool noDelay = true) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 100; ++i) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            int opt = noDelay ? 1 : 0;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            return fd;
+        }
+        close(fd);
+        usleep(20 * 1000);
+    }
+    return -1;
+}
+
+// 建立一对互相连接的回环TCP套接字，fds[0]为客户端，fds[1]为服务端
+inline bool tcpPair(int fds[2]) {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 1) < 0 ||
+        getsockname(listenFd, (struct sockaddr *)&addr, &len) < 0) {
+        close(listenFd);
+        return false;
+    }
+    fds[0] = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(fds[0], (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fds[0]);
+        close(listenFd);
+        return false;
+    }
+    fds[1] = accept(listenFd, nullptr, nullptr);
+    close(listenFd);
+    return fds[1] >= 0;
+}
+
+// 把RLIMIT_NOFILE提高到硬限制，返回可用的fd数
+inline size_t raiseFdLimit() {
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    return rl.rlim_cur;
+}
+
+} // namespace bench
+
+#endif
@@ -0,0 +1,208 @@
+// 广播扇出：把同一条消息发给N个连接(默认10万)，从发起到所有客户端都收到为一轮
+// 对比TcpServer::broadcast(共享BufferSlice，每个EventLoop只转交一次)
+// 与原来的做法(对每个连接sendInLoop一份string拷贝，每个连接一次转交)
+// 客户端在子进程中，每个子进程用自己的127.0.0.x作源地址，避开单个源地址的临时端口上限
+// 服务端进程要为每个连接占用一个fd，连接数受RLIMIT_NOFILE限制，不够时按可用的fd数减少
+// 用法：make bench && ./bench/broadcast_bench [连接数]
+#include "../Logger.h"
+#include "../TcpConnection.h"
+#include "../TcpServer.h"
+#include "BenchUtil.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <thread>
+
+namespace {
+
+const unsigned short kPort = 12394;
+const size_t kPayload = 256;
+const int kRounds = 20;
+const size_t kReservedFds = 64; // 监听、eventfd、timerfd、管道等
+
+enum class Mode {
+    Broadcast,
+    CopyEach
+};
+
+bool readByte(int fd) {
+    char c;
+    return read(fd, &c, 1) == 1;
+}
+
+void writeByte(int fd) {
+    char c = 0;
+    ssize_t ret = write(fd, &c, 1);
+    (void)ret;
+}
+
+// 子进程：从127.0.0.(2 + index)建立connNum个连接，报告连接完成，
+// 之后每收齐一轮(每个连接kPayload字节)就向report写一个字节
+void runClients(int index, size_t connNum, int rounds, int report) {
+    struct sockaddr_in src;
+    memset(&src, 0, sizeof(src));
+    src.sin_family = AF_INET;
+    src.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 2 + index);
+    struct sockaddr_in dst;
+    memset(&dst, 0, sizeof(dst));
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(kPort);
+    dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int epfd = epoll_create1(0);
+    vector<int> fds;
+    for (size_t i = 0; i < connNum; ++i) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        // 端口到connect时再按四元组分配，同一源地址可以连出超过临时端口数的连接
+        setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &on, sizeof(on));
+        if (fd < 0 || bind(fd, (struct sockaddr *)&src, sizeof(src)) < 0 ||
+            connect(fd, (struct sockaddr *)&dst, sizeof(dst)) < 0) {
+            perror("client connect");
+            _exit(1);
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = (uint32_t)fds.size();
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+        fds.push_back(fd);
+    }
+    writeByte(report);
+    vector<size_t> received(connNum, 0);
+    vector<struct epoll_event> events(1024);
+    char buf[65536];
+    for (int round = 1; round <= rounds; ++round) {
+        size_t target = round * kPayload;
+        size_t done = 0;
+        for (size_t got : received) {
+            done += got >= target;
+        }
+        while (done < connNum) {
+            int n = epoll_wait(epfd, events.data(), (int)events.size(), -1);
+            for (int i = 0; i < n; ++i) {
+                uint32_t idx = events[i].data.u32;
+                ssize_t len = read(fds[idx], buf, sizeof(buf));
+                if (len <= 0) {
+                    _exit(1);
+                }
+                bool before = received[idx] >= target;
+                received[idx] += len;
+                if (!before && received[idx] >= target) {
+                    ++done;
+                }
+            }
+        }
+        writeByte(report);
+    }
+    _exit(0);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    size_t want = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+    size_t fdLimit = bench::raiseFdLimit();
+    size_t connNum = std::min(want, fdLimit - kReservedFds);
+    if (connNum < want) {
+        printf("RLIMIT_NOFILE为%zu，连接数从%zu减为%zu\n", fdLimit, want, connNum);
+    }
+    // 每个子进程最多连出(fdLimit - kReservedFds)个连接
+    size_t perChild = fdLimit - kReservedFds;
+    int children = (int)((connNum + perChild - 1) / perChild);
+
+    // 先fork客户端，再创建服务端线程
+    int reportPipe[2];
+    if (pipe(reportPipe) < 0) {
+        perror("pipe");
+        return 1;
+    }
+    int goPipe[2];
+    if (pipe(goPipe) < 0) {
+        perror("pipe");
+        return 1;
+    }
+    vector<pid_t> pids;
+    for (int i = 0; i < children; ++i) {
+        size_t share = std::min(perChild, connNum - i * perChild);
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(reportPipe[0]);
+            close(goPipe[1]);
+            readByte(goPipe[0]); // 等服务端开始监听
+            runClients(i, share, 2 * kRounds, reportPipe[1]);
+        }
+        pids.push_back(pid);
+    }
+    close(reportPipe[1]);
+    close(goPipe[0]);
+
+    Logger::setLevel(kLogWarn);
+    size_t ioThreads = std::max(1u, std::thread::hardware_concurrency());
+    TcpServer server("127.0.0.1", kPort, 1024, ioThreads);
+    server.setBacklog(SOMAXCONN);
+    std::mutex mutex;
+    vector<shared_ptr<TcpConnection>> conns;
+    server.setAllCallback(
+        [&](const shared_ptr<TcpConnection> &conn) {
+            std::lock_guard<std::mutex> lock(mutex);
+            conns.push_back(conn);
+        },
+        functionCallback(), functionCallback());
+    std::thread loop([&server]() { server.start(); });
+    usleep(100 * 1000);
+
+    double begin = bench::nowSec();
+    for (int i = 0; i < children; ++i) {
+        writeByte(goPipe[1]);
+    }
+    for (int i = 0; i < children; ++i) {
+        if (!readByte(reportPipe[0])) {
+            printf("客户端连接失败\n");
+            return 1;
+        }
+    }
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (conns.size() == connNum) {
+                break;
+            }
+        }
+        usleep(1000);
+    }
+    printf("%zu个连接(%zu个IO线程，%d个客户端进程)建立用时%.2f秒\n", connNum, ioThreads, children, bench::nowSec() - begin);
+
+    string payload(kPayload, 'b');
+    printf("%12s %14s %14s %16s\n", "方式", "每轮中位(ms)", "每轮最慢(ms)", "投递(万条/秒)");
+    for (Mode mode : {Mode::Broadcast, Mode::CopyEach}) {
+        vector<double> rounds;
+        for (int round = 0; round < kRounds; ++round) {
+            double start = bench::nowSec();
+            if (mode == Mode::Broadcast) {
+                server.broadcast(conns, BufferSlice(payload.data(), payload.size()));
+            } else {
+                for (const shared_ptr<TcpConnection> &conn : conns) {
+                    conn->sendInLoop(payload);
+                }
+            }
+            for (int i = 0; i < children; ++i) {
+                readByte(reportPipe[0]);
+            }
+            rounds.push_back(bench::nowSec() - start);
+        }
+        std::sort(rounds.begin(), rounds.end());
+        double median = bench::percentile(rounds, 0.5);
+        printf("%12s %14.2f %14.2f %16.1f\n", mode == Mode::Broadcast ? "broadcast" : "逐个拷贝", median * 1e3,
+               rounds.back() * 1e3, connNum / median / 1e4);
+    }
+
+    for (pid_t pid : pids) {
+        waitpid(pid, nullptr, 0);
+    }
+    conns.clear();
+    server.stop();
+    loop.join();
+    return 0;
+}
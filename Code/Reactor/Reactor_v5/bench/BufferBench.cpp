@@ -0,0 +1,141 @@
+// 输入路径的系统调用次数和吞吐量：原来的receive(256字节栈数组 + memset，readLine每次read一个字节)
+// 与Buffer::readFd(readv读入缓冲区和64KB栈上溢出区) + findLines对比
+// 写端线程通过回环TCP连续发送文本行，读端把它们全部切成行
+// 用法：make bench && ./bench/buffer_bench
+#include "../Buffer.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using std::string;
+
+namespace {
+
+// 原来的逐字节读取要几十秒，只发少量数据
+const size_t kOldBytes = 4 * 1024 * 1024;
+const size_t kNewBytes = 256 * 1024 * 1024;
+
+struct Result {
+    double mbPerSec;
+    double syscallsPerLine;
+};
+
+// 原来的SocketIO::readLine：每次read一个字节，读到'\n'或读满len - 1为止
+int readLineBytewise(int fd, char *buf, int len, uint64_t *syscalls) {
+    int count = 0;
+    char c;
+    while (count < len - 1) {
+        ++*syscalls;
+        ssize_t ret = read(fd, &c, 1);
+        if (ret <= 0) {
+            break;
+        }
+        buf[count++] = c;
+        if (c == '\n') {
+            break;
+        }
+    }
+    buf[count] = '\0';
+    return count;
+}
+
+// 原来的TcpConnection::receive：取出一条消息
+string receiveOld(int fd, uint64_t *syscalls) {
+    string str;
+    char buf[256];
+    while (true) {
+        memset(buf, 0, 256);
+        int readSize = readLineBytewise(fd, buf, 256, syscalls);
+        if (readSize > 0) {
+            str += buf;
+        }
+        if (readSize < 256) {
+            break;
+        }
+    }
+    return str;
+}
+
+// 写端线程发送total字节，每行lineLen字节(含'\n')，每次write 64KB
+template <typename Reader>
+Result run(size_t lineLen, size_t total, Reader &&reader) {
+    int fds[2];
+    if (!bench::tcpPair(fds)) {
+        perror("tcpPair");
+        return Result{0, 0};
+    }
+    string line(lineLen - 1, 'x');
+    line.push_back('\n');
+    string chunk;
+    while (chunk.size() + lineLen <= 65536) {
+        chunk += line;
+    }
+    size_t lines = total / chunk.size() * (chunk.size() / lineLen);
+    size_t bytes = lines * lineLen;
+    std::thread writer([&]() {
+        for (size_t sent = 0; sent < bytes; sent += chunk.size()) {
+            const char *p = chunk.data();
+            size_t left = chunk.size();
+            while (left > 0) {
+                ssize_t n = write(fds[0], p, left);
+                if (n <= 0) {
+                    return;
+                }
+                p += n;
+                left -= n;
+            }
+        }
+    });
+    uint64_t syscalls = 0;
+    double begin = bench::nowSec();
+    size_t got = reader(fds[1], lines, &syscalls);
+    double sec = bench::nowSec() - begin;
+    writer.join();
+    close(fds[0]);
+    close(fds[1]);
+    if (got != lines) {
+        printf("结果错误：%zu/%zu行\n", got, lines);
+    }
+    return Result{bytes / sec / 1e6, (double)syscalls / lines};
+}
+
+}
+
+int main() {
+    printf("%8s %14s %14s %14s %14s\n", "行长", "原来MB/s", "原来read/行", "Buffer MB/s", "Buffer readv/行");
+    for (size_t lineLen : {16, 64, 256, 1024}) {
+        // 原来的receive每次最多取255字节，更长的行分成几次返回，按拼回的行计数
+        Result old = run(lineLen, kOldBytes, [](int fd, size_t lines, uint64_t *syscalls) {
+            size_t got = 0;
+            string pending;
+            while (got < lines) {
+                pending += receiveOld(fd, syscalls);
+                if (!pending.empty() && pending.back() == '\n') {
+                    ++got;
+                    pending.clear();
+                }
+            }
+            return got;
+        });
+        Result buffered = run(lineLen, kNewBytes, [](int fd, size_t lines, uint64_t *syscalls) {
+            Buffer buf(0);
+            vector<LineView> views;
+            size_t got = 0;
+            while (got < lines) {
+                int savedErrno = 0;
+                ++*syscalls;
+                if (buf.readFd(fd, &savedErrno) <= 0) {
+                    break;
+                }
+                views.clear();
+                buf.retrieve(buf.findLines(&views));
+                got += views.size();
+            }
+            return got;
+        });
+        printf("%8zu %14.1f %14.2f %14.1f %14.4f\n", lineLen, old.mbPerSec, old.syscallsPerLine, buffered.mbPerSec,
+               buffered.syscallsPerLine);
+    }
+    return 0;
+}
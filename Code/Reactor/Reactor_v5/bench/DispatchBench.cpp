@@ -0,0 +1,78 @@
+// 事件分发时查找连接的开销：原来的std::map(count + operator[])与以fd为下标的ConnectionTable对比
+// 在1k/10k/100k个连接中按随机顺序查找，模拟epoll返回的就绪fd，每次查找后读一次连接的字段
+// 只测查找本身，不建立真实的套接字，连接对象的fd为-1
+// 用法：make bench && ./bench/dispatch_bench
+#include "../ConnectionTable.h"
+#include "../TcpConnection.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+using std::map;
+using std::vector;
+
+namespace {
+
+const size_t kEvents = 10 * 1000 * 1000;
+const int kFirstFd = 16; // 0-2和监听、eventfd等占用了前面的fd
+
+template <typename Func>
+double nsPerEvent(const vector<int> &events, Func &&dispatch) {
+    uint64_t sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int fd : events) {
+        sink += dispatch(fd);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    if (sink == 0) {
+        printf("结果错误\n");
+    }
+    return ns / events.size();
+}
+
+}
+
+int main() {
+    printf("%10s %14s %14s %16s (ns/事件)\n", "连接数", "map查找", "table按fd", "table按编号");
+    std::mt19937 rng(12345);
+    InetAddress peer;
+    for (size_t connNum : {1000, 10000, 100000}) {
+        map<int, shared_ptr<TcpConnection>> connMap;
+        ConnectionTable table;
+        vector<ConnId> ids(kFirstFd + connNum);
+        for (size_t i = 0; i < connNum; ++i) {
+            int fd = kFirstFd + (int)i;
+            shared_ptr<TcpConnection> conn = std::make_shared<TcpConnection>(-1, nullptr, peer);
+            connMap[fd] = conn;
+            ids[fd] = table.insert(fd, conn);
+        }
+        // 就绪事件的顺序与fd大小无关
+        vector<int> events(kEvents);
+        std::uniform_int_distribution<int> pick(kFirstFd, kFirstFd + (int)connNum - 1);
+        for (int &fd : events) {
+            fd = pick(rng);
+        }
+
+        // 原来handelMessage的写法：先count确认存在，再operator[]取出
+        double mapNs = nsPerEvent(events, [&connMap](int fd) -> uint64_t {
+            if (!connMap.count(fd)) {
+                return 0;
+            }
+            return connMap[fd]->getEvents();
+        });
+        double tableNs = nsPerEvent(events, [&table](int fd) -> uint64_t {
+            TcpConnection *conn = table.find(fd);
+            return conn ? conn->getEvents() : 0;
+        });
+        // 其他线程持有编号时的查找，多一次代数比较和引用计数
+        double idNs = nsPerEvent(events, [&table, &ids](int fd) -> uint64_t {
+            shared_ptr<TcpConnection> conn = table.get(ids[fd]);
+            return conn ? conn->getEvents() : 0;
+        });
+        printf("%10zu %14.1f %14.1f %16.1f\n", connNum, mapNs, tableNs, idNs);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// 行切分的微基准：逐字节扫描、直接调用memchr与LineScanner::scanLines的吞吐量对比
+// 用法：make bench && ./bench/line_scanner_bench
+#include "../Codec.h"
+#include "../LineScanner.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+const size_t kBufSize = 4 * 1024 * 1024;
+const int kRounds = 50;
+
+// 每行lineLen字节(含'\n')
+string makeInput(size_t lineLen) {
+    string buf;
+    buf.reserve(kBufSize);
+    while (buf.size() + lineLen <= kBufSize) {
+        buf.append(lineLen - 1, 'a');
+        buf.push_back('\n');
+    }
+    return buf;
+}
+
+size_t scanBytewise(const char *data, size_t len, vector<LineView> *lines) {
+    size_t start = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if (data[i] == '\n') {
+            lines->push_back(LineView{data + start, i - start});
+            start = i + 1;
+        }
+    }
+    return start;
+}
+
+size_t scanMemchr(const char *data, size_t len, vector<LineView> *lines) {
+    const char *end = data + len;
+    const char *lineStart = data;
+    while (lineStart < end) {
+        const char *eol = static_cast<const char *>(memchr(lineStart, '\n', end - lineStart));
+        if (!eol) {
+            break;
+        }
+        lines->push_back(LineView{lineStart, static_cast<size_t>(eol - lineStart)});
+        lineStart = eol + 1;
+    }
+    return lineStart - data;
+}
+
+template <typename Func>
+double measure(const string &input, Func &&scan) {
+    size_t total = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; ++i) {
+        total += scan(input.data(), input.size());
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (total != input.size() * kRounds) {
+        printf("结果错误\n");
+    }
+    return static_cast<double>(total) / sec / 1e9;
+}
+
+}
+
+int main() {
+    printf("LineScanner实现：%s\n", LineScanner::implName());
+    printf("%8s %10s %10s %12s %12s (GB/s)\n", "行长", "逐字节", "memchr", "scanLines", "LineCodec");
+    vector<LineView> lines;
+    vector<Frame> frames;
+    LineCodec codec(kBufSize);
+    for (size_t lineLen : {16, 64, 256, 1024, 16384}) {
+        string input = makeInput(lineLen);
+        double bytewise = measure(input, [&](const char *d, size_t n) {
+            lines.clear();
+            return scanBytewise(d, n, &lines);
+        });
+        double mem = measure(input, [&](const char *d, size_t n) {
+            lines.clear();
+            return scanMemchr(d, n, &lines);
+        });
+        double simd = measure(input, [&](const char *d, size_t n) {
+            lines.clear();
+            return LineScanner::scanLines(d, n, &lines);
+        });
+        double decode = measure(input, [&](const char *d, size_t n) {
+            frames.clear();
+            return static_cast<size_t>(codec.decode(d, n, &frames));
+        });
+        printf("%8zu %10.2f %10.2f %12.2f %12.2f\n", lineLen, bytewise, mem, simd, decode);
+    }
+    return 0;
+}
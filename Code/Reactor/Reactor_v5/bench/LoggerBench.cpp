@@ -0,0 +1,216 @@
+// 日志的吞吐量和单次调用耗时：原来的std::cout << ... << endl(每条都同步flush，所有线程争同一把流锁)
+// 与LOG_INFO(格式化到栈上，写入本线程的LogRing，由后台线程批量写文件)对比，
+// 另外给出级别关闭时LOG_DEBUG的开销，"不打日志"一行是两次取时间本身的开销
+// LogRing满时LOG_INFO丢弃日志而不阻塞，丢弃的条数单独列出
+// 两者都写到/tmp下的文件，cout通过把标准输出重定向到文件实现
+// 最后在回环echo服务端的消息回调中分别不打日志、用cout、用LOG_INFO，比较往返延迟
+// 用法：make bench && ./bench/logger_bench
+#include "../Logger.h"
+#include "../TcpConnection.h"
+#include "../TcpServer.h"
+#include "BenchUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fcntl.h>
+#include <iostream>
+#include <thread>
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+const unsigned short kPort = 12393;
+const size_t kMsgsPerThread = 200 * 1000;
+const size_t kRoundTrips = 20000;
+const char kCoutPath[] = "/tmp/logger_bench_cout.log";
+const char kLogPath[] = "/tmp/logger_bench_async.log";
+
+enum class Mode {
+    None,
+    Cout,
+    Async,
+    Disabled
+};
+
+const char *modeName(Mode mode) {
+    switch (mode) {
+    case Mode::None:
+        return "不打日志";
+    case Mode::Cout:
+        return "cout+endl";
+    case Mode::Async:
+        return "LOG_INFO";
+    default:
+        return "LOG_DEBUG关闭";
+    }
+}
+
+// cout阶段把标准输出重定向到文件，结束后恢复
+class StdoutToFile {
+public:
+    explicit StdoutToFile(const char *path) : _saved(dup(STDOUT_FILENO)) {
+        fflush(stdout);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+    }
+
+    ~StdoutToFile() {
+        cout.flush();
+        fflush(stdout);
+        dup2(_saved, STDOUT_FILENO);
+        close(_saved);
+    }
+
+private:
+    int _saved;
+};
+
+// 和echo路径上的日志内容相近的一条消息
+void logOnce(Mode mode, size_t i, const string &msg) {
+    if (mode == Mode::Cout) {
+        cout << "收到：" << msg << " seq=" << i << endl;
+    } else if (mode == Mode::Async) {
+        LOG_INFO << "收到：" << msg << " seq=" << i;
+    } else if (mode == Mode::Disabled) {
+        LOG_DEBUG << "收到：" << msg << " seq=" << i;
+    }
+}
+
+struct Result {
+    double msgsPerSec;
+    uint64_t dropped;
+    double p50Ns;
+    double p99Ns;
+    double p999Ns;
+};
+
+Result runThroughput(Mode mode, int threads) {
+    string msg(48, 'm');
+    vector<vector<double>> costs(threads);
+    uint64_t droppedBefore = Logger::instance().dropped();
+    double begin = bench::nowSec();
+    vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([mode, &msg, &costs, t]() {
+            vector<double> &cost = costs[t];
+            cost.reserve(kMsgsPerThread);
+            for (size_t i = 0; i < kMsgsPerThread; ++i) {
+                uint64_t start = bench::nowNs();
+                logOnce(mode, i, msg);
+                cost.push_back(bench::nowNs() - start);
+            }
+        });
+    }
+    for (std::thread &th : workers) {
+        th.join();
+    }
+    double sec = bench::nowSec() - begin;
+    uint64_t dropped = Logger::instance().dropped() - droppedBefore;
+    vector<double> all;
+    for (vector<double> &cost : costs) {
+        all.insert(all.end(), cost.begin(), cost.end());
+    }
+    std::sort(all.begin(), all.end());
+    return Result{all.size() / sec, dropped, bench::percentile(all, 0.5), bench::percentile(all, 0.99),
+                  bench::percentile(all, 0.999)};
+}
+
+// 一个连接上逐条发送64字节的行并等待回显，返回排好序的往返时间(微秒)
+vector<double> runEcho() {
+    vector<double> rtts;
+    int fd = bench::connectTcp(kPort);
+    if (fd < 0) {
+        return rtts;
+    }
+    string line(63, 'e');
+    line.push_back('\n');
+    char buf[256];
+    for (size_t i = 0; i < kRoundTrips; ++i) {
+        uint64_t start = bench::nowNs();
+        if (write(fd, line.data(), line.size()) != (ssize_t)line.size()) {
+            break;
+        }
+        size_t got = 0;
+        while (got < line.size()) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) {
+                close(fd);
+                return rtts;
+            }
+            got += n;
+        }
+        rtts.push_back((bench::nowNs() - start) / 1e3);
+    }
+    close(fd);
+    std::sort(rtts.begin(), rtts.end());
+    return rtts;
+}
+
+}
+
+int main() {
+    Logger::instance().setRingSize(16 << 20);
+    unlink(kLogPath);
+    if (!Logger::instance().start(kLogPath)) {
+        return 1;
+    }
+    Logger::setLevel(kLogInfo);
+
+    printf("每个线程%zu条，单次耗时单位ns\n", kMsgsPerThread);
+    printf("%6s %14s %14s %10s %10s %10s %10s\n", "线程", "方式", "万条/秒", "丢弃", "p50", "p99", "p99.9");
+    for (int threads : {1, 2, 4, 8}) {
+        for (Mode mode : {Mode::None, Mode::Cout, Mode::Async, Mode::Disabled}) {
+            Result result;
+            if (mode == Mode::Cout) {
+                StdoutToFile redirect(kCoutPath);
+                result = runThroughput(mode, threads);
+            } else {
+                result = runThroughput(mode, threads);
+            }
+            printf("%6d %14s %14.1f %10llu %10.0f %10.0f %10.0f\n", threads, modeName(mode), result.msgsPerSec / 1e4,
+                   (unsigned long long)result.dropped, result.p50Ns, result.p99Ns, result.p999Ns);
+        }
+    }
+
+    // echo路径：消息回调在loop线程中打一条日志再回显
+    std::atomic<Mode> echoMode(Mode::None);
+    size_t seq = 0; // 只在loop线程中使用
+    TcpServer server("127.0.0.1", kPort, 64);
+    server.setAllCallback(
+        functionCallback(),
+        [&](const shared_ptr<TcpConnection> &conn) {
+            string msg = conn->receive();
+            logOnce(echoMode, seq++, msg);
+            conn->send(std::move(msg));
+        },
+        functionCallback());
+    std::thread loop([&server]() { server.start(); });
+    usleep(100 * 1000);
+    printf("echo往返%zu次，单位us\n", kRoundTrips);
+    printf("%14s %10s %10s %10s\n", "方式", "p50", "p99", "p99.9");
+    for (Mode mode : {Mode::None, Mode::Cout, Mode::Async}) {
+        echoMode = mode;
+        vector<double> rtts;
+        if (mode == Mode::Cout) {
+            StdoutToFile redirect(kCoutPath);
+            rtts = runEcho();
+        } else {
+            rtts = runEcho();
+        }
+        if (rtts.empty()) {
+            printf("连接失败\n");
+            break;
+        }
+        printf("%14s %10.1f %10.1f %10.1f\n", modeName(mode), bench::percentile(rtts, 0.5),
+               bench::percentile(rtts, 0.99), bench::percentile(rtts, 0.999));
+    }
+    server.stop();
+    loop.join();
+    Logger::instance().stop();
+    unlink(kCoutPath);
+    unlink(kLogPath);
+    return 0;
+}
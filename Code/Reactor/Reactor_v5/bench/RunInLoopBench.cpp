@@ -0,0 +1,156 @@
+// 工作线程把回复交给EventLoop的吞吐量：1到32个生产者线程同时runInLoop
+// 对比原来的实现(互斥锁 + vector，每次入队都写eventfd)和现在的无锁MPSC队列 + 合并唤醒
+// 每个任务模拟一次sendInLoop，只在EventLoop线程里累加计数
+// "取任务次数"是loop线程被唤醒后取队列的次数：原来的实现每个任务都写一次eventfd，
+// 现在只有队列从空变为非空时才写
+// 用法：make bench && ./bench/runinloop_bench
+#include "../EventLoop.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using std::vector;
+
+namespace {
+
+const size_t kTasks = 2 * 1000 * 1000;
+
+// 原来EventLoop的任务队列：加锁入队，每次都写eventfd唤醒
+class MutexLoop {
+public:
+    MutexLoop() : _eventFd(eventfd(0, 0)), _epfd(epoll_create1(0)), _running(true), _wakeups(0) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = _eventFd;
+        epoll_ctl(_epfd, EPOLL_CTL_ADD, _eventFd, &ev);
+    }
+
+    ~MutexLoop() {
+        close(_eventFd);
+        close(_epfd);
+    }
+
+    void loop() {
+        struct epoll_event ev;
+        vector<Task> tasks;
+        while (_running) {
+            if (epoll_wait(_epfd, &ev, 1, -1) <= 0) {
+                continue;
+            }
+            uint64_t one;
+            ssize_t ret = read(_eventFd, &one, sizeof(one));
+            (void)ret;
+            ++_wakeups;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                tasks.swap(_pendings);
+            }
+            for (Task &task : tasks) {
+                task();
+            }
+            tasks.clear();
+        }
+    }
+
+    void runInLoop(Task &&task) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pendings.push_back(std::move(task));
+        }
+        uint64_t one = 1;
+        ssize_t ret = write(_eventFd, &one, sizeof(one));
+        (void)ret;
+    }
+
+    void unLoop() {
+        runInLoop([this]() { _running = false; });
+    }
+
+    uint64_t wakeups() {
+        return _wakeups;
+    }
+
+private:
+    int _eventFd;
+    int _epfd;
+    bool _running;
+    std::atomic<uint64_t> _wakeups;
+    std::mutex _mutex;
+    vector<Task> _pendings;
+};
+
+struct Result {
+    double tasksPerSec;
+    uint64_t wakeups;
+};
+
+// producers个线程共提交kTasks个任务，计时到最后一个任务在loop线程执行完为止
+template <typename Loop>
+Result run(Loop &loop, int producers, std::function<uint64_t()> wakeups) {
+    uint64_t executed = 0; // 只在loop线程中修改
+    std::atomic<bool> done(false);
+    size_t perThread = kTasks / producers;
+    auto begin = std::chrono::steady_clock::now();
+    vector<std::thread> threads;
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&loop, &executed, perThread]() {
+            for (size_t n = 0; n < perThread; ++n) {
+                loop.runInLoop([&executed]() { ++executed; });
+            }
+        });
+    }
+    for (std::thread &th : threads) {
+        th.join();
+    }
+    // 队列先进先出，这个任务执行时前面的都已执行完
+    loop.runInLoop([&done]() { done = true; });
+    while (!done) {
+        std::this_thread::yield();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (executed != perThread * producers) {
+        printf("结果错误：%llu\n", (unsigned long long)executed);
+    }
+    return Result{executed / sec, wakeups()};
+}
+
+}
+
+int main() {
+    printf("CPU数：%u\n", std::thread::hardware_concurrency());
+    printf("%8s %16s %14s %16s %14s\n", "生产者", "互斥锁(万/秒)", "取任务次数", "MPSC(万/秒)", "取任务次数");
+    for (int producers : {1, 2, 4, 8, 16, 32}) {
+        Result old;
+        {
+            MutexLoop loop;
+            std::thread th(&MutexLoop::loop, &loop);
+            old = run(loop, producers, [&loop]() { return loop.wakeups(); });
+            loop.unLoop();
+            th.join();
+        }
+        Result mpsc;
+        {
+            EventLoop loop(16);
+            std::thread th(&EventLoop::loop, &loop);
+            // 等loop线程开始运行，之后的统计才从零开始算
+            std::atomic<bool> started(false);
+            loop.queueInLoop([&started]() { started = true; });
+            while (!started) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            uint64_t base = loop.getStats().pendingPerDrain.count;
+            mpsc = run(loop, producers, [&loop, base]() { return loop.getStats().pendingPerDrain.count - base; });
+            loop.unLoop();
+            th.join();
+        }
+        printf("%8d %16.1f %14llu %16.1f %14llu\n", producers, old.tasksPerSec / 1e4,
+               (unsigned long long)old.wakeups, mpsc.tasksPerSec / 1e4, (unsigned long long)mpsc.wakeups);
+    }
+    return 0;
+}
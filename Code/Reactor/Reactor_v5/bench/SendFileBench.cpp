@@ -0,0 +1,140 @@
+// 通过回环连接发送一个几GB的文件：TcpConnection::sendFile(sendfile，不经过用户态)
+// 与原来的做法(pread读进string再send，每次1MB，写完成回调里读下一块)对比
+// 报告吞吐量和整个进程消耗的CPU时间，两种方式的客户端开销相同
+// 用法：make bench && ./bench/sendfile_bench [文件大小GB，默认2]
+#include "../Logger.h"
+#include "../TcpConnection.h"
+#include "../TcpServer.h"
+#include "BenchUtil.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <thread>
+
+namespace {
+
+const unsigned short kPort = 12395;
+const size_t kChunk = 1 << 20;
+
+enum class Mode {
+    SendFile,
+    ReadSend
+};
+
+double cpuSec() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+// 写入真实数据而不是留空洞，sendfile读空洞时走的是零页
+bool makeFile(int fd, size_t size) {
+    string block(kChunk, '\0');
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<char>(i * 131);
+    }
+    for (size_t done = 0; done < size; done += block.size()) {
+        if (write(fd, block.data(), block.size()) != (ssize_t)block.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 读完size字节返回用时，连接断开时返回负数
+double download(size_t size) {
+    int fd = bench::connectTcp(kPort);
+    if (fd < 0) {
+        return -1;
+    }
+    vector<char> buf(kChunk);
+    size_t got = 0;
+    double begin = bench::nowSec();
+    while (got < size) {
+        ssize_t n = read(fd, buf.data(), buf.size());
+        if (n <= 0) {
+            close(fd);
+            return -1;
+        }
+        got += n;
+    }
+    double sec = bench::nowSec() - begin;
+    close(fd);
+    return sec;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    size_t gb = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2;
+    size_t fileSize = gb << 30;
+    char path[] = "/tmp/sendfile_bench_XXXXXX";
+    int fileFd = mkstemp(path);
+    if (fileFd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    unlink(path);
+    printf("生成%zuGB的文件...\n", gb);
+    if (!makeFile(fileFd, fileSize)) {
+        perror("write");
+        return 1;
+    }
+
+    Logger::setLevel(kLogWarn);
+    std::atomic<Mode> mode(Mode::SendFile);
+    size_t offset = 0; // 只在loop线程中使用，一次只有一个连接
+    auto sendNextChunk = [fileFd, fileSize, &offset](const shared_ptr<TcpConnection> &conn) {
+        if (offset >= fileSize) {
+            return;
+        }
+        string chunk(std::min(kChunk, fileSize - offset), '\0');
+        ssize_t n = pread(fileFd, &chunk[0], chunk.size(), offset);
+        if (n <= 0) {
+            return;
+        }
+        chunk.resize(n);
+        offset += n;
+        conn->send(std::move(chunk));
+    };
+    TcpServer server("127.0.0.1", kPort, 64);
+    server.setAllCallback(
+        [&](const shared_ptr<TcpConnection> &conn) {
+            if (mode == Mode::SendFile) {
+                conn->sendFile(fileFd, 0, fileSize);
+            } else {
+                offset = 0;
+                sendNextChunk(conn);
+            }
+        },
+        functionCallback(), functionCallback());
+    server.setWriteCompleteCallback([&](const shared_ptr<TcpConnection> &conn) {
+        if (mode == Mode::ReadSend) {
+            sendNextChunk(conn);
+        }
+    });
+    std::thread loop([&server]() { server.start(); });
+
+    // 先各跑一次预热页缓存，第二次计时
+    printf("%12s %12s %14s\n", "方式", "GB/s", "CPU秒/GB");
+    for (Mode m : {Mode::SendFile, Mode::ReadSend}) {
+        mode = m; // 下一个连接建立时才读取，此时没有连接
+        download(fileSize);
+        double cpuBegin = cpuSec();
+        double sec = download(fileSize);
+        double cpu = cpuSec() - cpuBegin;
+        if (sec < 0) {
+            printf("下载失败\n");
+            break;
+        }
+        printf("%12s %12.2f %14.2f\n", m == Mode::SendFile ? "sendfile" : "pread+send", fileSize / sec / (1 << 30),
+               cpu / gb);
+    }
+
+    server.stop();
+    loop.join();
+    close(fileFd);
+    return 0;
+}
@@ -0,0 +1,325 @@
+// SocketOptions中每个选项的效果：同一个场景下分别关闭/开启一个选项，其余保持默认
+// tcpNoDelay：服务端先回16字节头部，200us后再回16字节正文(写-写-读)，Nagle会把正文扣到头部被ACK为止
+// quickAck：客户端开着Nagle分两次写一个请求，第二段要等服务端ACK第一段，服务端凑齐才回复
+// deferAcceptSec：只连接不发数据的客户端会不会被accept，以及新连接的连接-请求-回复耗时
+// fastOpenQueue：客户端用MSG_FASTOPEN在SYN中带请求，需要net.ipv4.tcp_fastopen包含0x2服务端才接受
+// recvBuf/sendBuf：回显256MB的吞吐量，设置后内核不再自动调整缓冲区
+// lingerSec=0：客户端先关闭的短连接，服务端用RST代替FIN，客户端不进入TIME_WAIT
+// 用法：make bench && ./bench/sockopt_bench
+#include "../Logger.h"
+#include "../TcpConnection.h"
+#include "../TcpServer.h"
+#include "BenchUtil.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace {
+
+const unsigned short kBasePort = 12380;
+const size_t kSlowRounds = 100; // 每次可能等40ms延迟ACK的场景
+const size_t kConnRounds = 1000;
+const size_t kChurnConns = 5000;
+const size_t kStreamBytes = 256 * 1024 * 1024;
+const size_t kMsgSize = 16;
+
+// 每个场景一个端口，前一个场景残留的TIME_WAIT不影响后面的统计
+unsigned short nextPort() {
+    static unsigned short port = kBasePort;
+    return port++;
+}
+
+class BenchServer {
+public:
+    BenchServer(unsigned short port, const SocketOptions &opts, functionCallback &&msg,
+                functionCallback &&newConn = functionCallback())
+        : _server(std::make_shared<TcpServer>("127.0.0.1", port, 64, 0, PollerType::Epoll, opts)) {
+        _server->setAllCallback(std::move(newConn), std::move(msg), functionCallback());
+        shared_ptr<TcpServer> server = _server;
+        _loop = std::thread([server]() { server->start(); });
+        // 等loop开始运行再返回，否则stop可能早于loop，loop之后不会再退出
+        usleep(100 * 1000);
+    }
+
+    ~BenchServer() {
+        _server->stop();
+        _loop.join();
+    }
+
+private:
+    shared_ptr<TcpServer> _server;
+    std::thread _loop;
+};
+
+void echo(const shared_ptr<TcpConnection> &conn) {
+    conn->send(conn->receive());
+}
+
+bool readN(int fd, size_t n) {
+    char buf[65536];
+    while (n > 0) {
+        ssize_t ret = read(fd, buf, std::min(n, sizeof(buf)));
+        if (ret <= 0) {
+            return false;
+        }
+        n -= ret;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+struct sockaddr_in loopbackAddr(unsigned short port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+void printLatency(const char *knob, const char *setting, vector<double> &samples, const char *unit) {
+    std::sort(samples.begin(), samples.end());
+    printf("%-16s %-10s p50 %8.1f%s  p99 %8.1f%s\n", knob, setting, bench::percentile(samples, 0.5), unit,
+           bench::percentile(samples, 0.99), unit);
+}
+
+// 写-写-读：回复分两次发出
+void benchNoDelay() {
+    for (bool noDelay : {false, true}) {
+        SocketOptions opts;
+        opts.tcpNoDelay = noDelay;
+        unsigned short port = nextPort();
+        BenchServer server(port, opts, [](const shared_ptr<TcpConnection> &conn) {
+            conn->receive();
+            conn->send(string(kMsgSize, 'h'));
+            shared_ptr<TcpConnection> self = conn;
+            conn->getLoop()->runAfter(Interval(200), [self]() { self->send(string(kMsgSize, 'b')); });
+        });
+        int fd = bench::connectTcp(port);
+        string req(kMsgSize, 'q');
+        vector<double> rtts;
+        for (size_t i = 0; i < kSlowRounds; ++i) {
+            double start = bench::nowSec();
+            if (!writeAll(fd, req.data(), req.size()) || !readN(fd, 2 * kMsgSize)) {
+                break;
+            }
+            rtts.push_back((bench::nowSec() - start) * 1e3);
+        }
+        close(fd);
+        printLatency("tcpNoDelay", noDelay ? "开" : "关", rtts, "ms");
+    }
+}
+
+// 请求分两次写，客户端不关Nagle
+void benchQuickAck() {
+    for (bool quickAck : {false, true}) {
+        SocketOptions opts;
+        opts.quickAck = quickAck;
+        unsigned short port = nextPort();
+        BenchServer server(port, opts, [](const shared_ptr<TcpConnection> &conn) {
+            Buffer *input = conn->inputBuffer();
+            while (input->readableBytes() >= 2 * kMsgSize) {
+                input->retrieve(2 * kMsgSize);
+                conn->send(string(kMsgSize, 'r'));
+            }
+        });
+        int fd = bench::connectTcp(port, false);
+        string part(kMsgSize, 'q');
+        vector<double> rtts;
+        for (size_t i = 0; i < kSlowRounds; ++i) {
+            double start = bench::nowSec();
+            if (!writeAll(fd, part.data(), part.size()) || !writeAll(fd, part.data(), part.size()) ||
+                !readN(fd, kMsgSize)) {
+                break;
+            }
+            rtts.push_back((bench::nowSec() - start) * 1e3);
+        }
+        close(fd);
+        printLatency("quickAck", quickAck ? "开" : "关", rtts, "ms");
+    }
+}
+
+// 新连接上的一次请求-回复，返回耗时(微秒)，失败时返回负数
+double connectAndRequest(unsigned short port, bool fastOpen, bool *synData) {
+    struct sockaddr_in addr = loopbackAddr(port);
+    string req(kMsgSize, 'q');
+    double start = bench::nowSec();
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    bool ok;
+    if (fastOpen) {
+        // 没有cookie时内核退回普通的三次握手，数据在握手后发出
+        ok = sendto(fd, req.data(), req.size(), MSG_FASTOPEN, (struct sockaddr *)&addr, sizeof(addr)) ==
+             (ssize_t)req.size();
+    } else {
+        ok = connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0 && writeAll(fd, req.data(), req.size());
+    }
+    ok = ok && readN(fd, kMsgSize);
+    double us = (bench::nowSec() - start) * 1e6;
+    if (synData != nullptr) {
+        struct tcp_info info;
+        socklen_t len = sizeof(info);
+        *synData = getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) == 0 && (info.tcpi_options & TCPI_OPT_SYN_DATA);
+    }
+    close(fd);
+    return ok ? us : -1;
+}
+
+void benchDeferAccept() {
+    const int kIdle = 100;
+    for (int sec : {0, 1}) {
+        SocketOptions opts;
+        opts.deferAcceptSec = sec;
+        unsigned short port = nextPort();
+        std::atomic<int> accepted(0);
+        BenchServer server(port, opts, echo, [&accepted](const shared_ptr<TcpConnection> &) { ++accepted; });
+        int base = accepted;
+        vector<int> idle;
+        for (int i = 0; i < kIdle; ++i) {
+            idle.push_back(bench::connectTcp(port));
+        }
+        usleep(50 * 1000);
+        int idleAccepted = accepted - base;
+        for (int fd : idle) {
+            close(fd);
+        }
+        vector<double> costs;
+        for (size_t i = 0; i < kConnRounds; ++i) {
+            double us = connectAndRequest(port, false, nullptr);
+            if (us >= 0) {
+                costs.push_back(us);
+            }
+        }
+        char setting[16];
+        snprintf(setting, sizeof(setting), "%d秒", sec);
+        printLatency("deferAcceptSec", setting, costs, "us");
+        printf("%-16s %-10s %d个不发数据的连接50ms内被accept了%d个\n", "", "", kIdle, idleAccepted);
+    }
+}
+
+int readSysctl(const char *path) {
+    std::ifstream in(path);
+    int value = -1;
+    in >> value;
+    return value;
+}
+
+void benchFastOpen() {
+    int sysctl = readSysctl("/proc/sys/net/ipv4/tcp_fastopen");
+    printf("net.ipv4.tcp_fastopen=%d%s\n", sysctl, (sysctl & 2) ? "" : "，未包含0x2，服务端不接受SYN中的数据");
+    for (int queue : {0, 16}) {
+        SocketOptions opts;
+        opts.fastOpenQueue = queue;
+        unsigned short port = nextPort();
+        BenchServer server(port, opts, echo);
+        vector<double> costs;
+        size_t synData = 0;
+        for (size_t i = 0; i < kConnRounds; ++i) {
+            bool used = false;
+            // 第一次连接取得cookie，不计入
+            double us = connectAndRequest(port, true, &used);
+            if (i > 0 && us >= 0) {
+                costs.push_back(us);
+                synData += used;
+            }
+        }
+        char setting[16];
+        snprintf(setting, sizeof(setting), "%d", queue);
+        printLatency("fastOpenQueue", setting, costs, "us");
+        printf("%-16s %-10s SYN中的数据被接受：%zu/%zu\n", "", "", synData, costs.size());
+    }
+}
+
+void benchBufferSizes() {
+    for (int size : {0, 64 * 1024, 4 * 1024 * 1024}) {
+        SocketOptions opts;
+        opts.recvBuf = size;
+        opts.sendBuf = size;
+        unsigned short port = nextPort();
+        BenchServer server(port, opts, echo);
+        int fd = bench::connectTcp(port);
+        double begin = bench::nowSec();
+        std::thread writer([fd]() {
+            string chunk(64 * 1024, 's');
+            for (size_t sent = 0; sent < kStreamBytes; sent += chunk.size()) {
+                if (!writeAll(fd, chunk.data(), chunk.size())) {
+                    return;
+                }
+            }
+        });
+        bool ok = readN(fd, kStreamBytes);
+        double sec = bench::nowSec() - begin;
+        writer.join();
+        close(fd);
+        char setting[16];
+        snprintf(setting, sizeof(setting), size == 0 ? "默认" : "%dKB", size / 1024);
+        printf("%-16s %-10s 回显%zuMB：%.1f MB/s\n", "recvBuf/sendBuf", setting, kStreamBytes >> 20,
+               ok ? kStreamBytes / sec / 1e6 : 0.0);
+    }
+}
+
+// /proc/net/tcp中对端端口为port、状态为TIME_WAIT(06)的套接字数
+int countTimeWait(unsigned short port) {
+    std::ifstream in("/proc/net/tcp");
+    string line;
+    std::getline(in, line);
+    int count = 0;
+    char remote[64];
+    char state[8];
+    unsigned remotePort;
+    while (std::getline(in, line)) {
+        if (sscanf(line.c_str(), "%*s %*s %63s %7s", remote, state) == 2 &&
+            sscanf(strchr(remote, ':') + 1, "%x", &remotePort) == 1 && remotePort == port &&
+            string(state) == "06") {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void benchLinger() {
+    for (int linger : {-1, 0}) {
+        SocketOptions opts;
+        opts.lingerSec = linger;
+        unsigned short port = nextPort();
+        BenchServer server(port, opts, echo);
+        string req(kMsgSize, 'q');
+        size_t done = 0;
+        double begin = bench::nowSec();
+        for (size_t i = 0; i < kChurnConns; ++i) {
+            int fd = bench::connectTcp(port);
+            if (fd >= 0 && writeAll(fd, req.data(), req.size()) && readN(fd, kMsgSize)) {
+                ++done;
+            }
+            close(fd);
+        }
+        double sec = bench::nowSec() - begin;
+        usleep(100 * 1000); // 等服务端关闭这边的连接
+        printf("%-16s %-10s %.0f个连接/秒，客户端TIME_WAIT %d/%zu\n", "lingerSec", linger < 0 ? "不设置" : "0",
+               done / sec, countTimeWait(port), kChurnConns);
+    }
+}
+
+}
+
+int main() {
+    Logger::setLevel(kLogWarn);
+    benchNoDelay();
+    benchQuickAck();
+    benchDeferAccept();
+    benchFastOpen();
+    benchBufferSizes();
+    benchLinger();
+    return 0;
+}
@@ -0,0 +1,149 @@
+// 同一台机器上的echo：Unix域套接字(抽象命名空间)与回环TCP(IPv4、IPv6)对比
+// 三个TcpServer使用相同的echo回调，只有监听地址不同
+// 往返延迟：一个连接上逐条发送并等待回显；吞吐量：写端线程连续发送，读端读回全部回显
+// 用法：make bench && ./bench/uds_bench
+#include "../Logger.h"
+#include "../TcpConnection.h"
+#include "../TcpServer.h"
+#include "BenchUtil.h"
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+const unsigned short kTcpPort = 12392;
+const size_t kRoundTrips = 50000;
+const size_t kStreamBytes = 256 * 1024 * 1024;
+const size_t kStreamChunk = 64 * 1024;
+
+struct Transport {
+    const char *name;
+    InetAddress addr;
+};
+
+int connectTo(const InetAddress &addr) {
+    for (int i = 0; i < 100; ++i) {
+        int fd = socket(addr.family(), SOCK_STREAM, 0);
+        if (connect(fd, addr.getSockAddr(), addr.getSockLen()) == 0) {
+            if (addr.family() != AF_UNIX) {
+                int on = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            }
+            return fd;
+        }
+        close(fd);
+        usleep(20 * 1000);
+    }
+    return -1;
+}
+
+// 往返时间(微秒)，已排序
+vector<double> pingPong(const InetAddress &addr, size_t msgSize) {
+    vector<double> rtts;
+    int fd = connectTo(addr);
+    if (fd < 0) {
+        return rtts;
+    }
+    string msg(msgSize, 'p');
+    vector<char> buf(msgSize);
+    for (size_t i = 0; i < kRoundTrips; ++i) {
+        uint64_t start = bench::nowNs();
+        if (write(fd, msg.data(), msg.size()) != (ssize_t)msg.size()) {
+            break;
+        }
+        size_t got = 0;
+        while (got < msgSize) {
+            ssize_t n = read(fd, buf.data(), buf.size());
+            if (n <= 0) {
+                close(fd);
+                return rtts;
+            }
+            got += n;
+        }
+        rtts.push_back((bench::nowNs() - start) / 1e3);
+    }
+    close(fd);
+    std::sort(rtts.begin(), rtts.end());
+    return rtts;
+}
+
+// 回显吞吐量MB/s，连接失败时返回0
+double stream(const InetAddress &addr) {
+    int fd = connectTo(addr);
+    if (fd < 0) {
+        return 0;
+    }
+    double begin = bench::nowSec();
+    std::thread writer([fd]() {
+        string chunk(kStreamChunk, 's');
+        for (size_t sent = 0; sent < kStreamBytes; sent += chunk.size()) {
+            const char *p = chunk.data();
+            size_t left = chunk.size();
+            while (left > 0) {
+                ssize_t n = write(fd, p, left);
+                if (n <= 0) {
+                    return;
+                }
+                p += n;
+                left -= n;
+            }
+        }
+    });
+    vector<char> buf(kStreamChunk);
+    size_t got = 0;
+    while (got < kStreamBytes) {
+        ssize_t n = read(fd, buf.data(), buf.size());
+        if (n <= 0) {
+            break;
+        }
+        got += n;
+    }
+    double sec = bench::nowSec() - begin;
+    writer.join();
+    close(fd);
+    return got == kStreamBytes ? kStreamBytes / sec / 1e6 : 0;
+}
+
+}
+
+int main() {
+    Logger::setLevel(kLogWarn);
+    vector<Transport> transports{
+        {"UDS(抽象)", InetAddress::unixPath("@reactor_uds_bench")},
+        {"TCP 127.0.0.1", InetAddress("127.0.0.1", kTcpPort)},
+        {"TCP ::1", InetAddress("::1", kTcpPort + 1)},
+    };
+    vector<shared_ptr<TcpServer>> servers;
+    vector<std::thread> loops;
+    for (Transport &t : transports) {
+        shared_ptr<TcpServer> server = std::make_shared<TcpServer>(t.addr, 64);
+        server->setAllCallback(
+            functionCallback(),
+            [](const shared_ptr<TcpConnection> &conn) { conn->send(conn->receive()); },
+            functionCallback());
+        loops.emplace_back([server]() { server->start(); });
+        servers.push_back(server);
+    }
+
+    printf("往返%zu次，单位us；吞吐量为%zuMB回显\n", kRoundTrips, kStreamBytes >> 20);
+    printf("%16s %10s %10s %10s %10s %14s\n", "传输", "64B p50", "64B p99", "4KB p50", "4KB p99", "吞吐量(MB/s)");
+    for (Transport &t : transports) {
+        vector<double> small = pingPong(t.addr, 64);
+        vector<double> large = pingPong(t.addr, 4096);
+        if (small.empty() || large.empty()) {
+            printf("%16s 连接失败\n", t.name);
+            continue;
+        }
+        double mbps = stream(t.addr);
+        printf("%16s %10.1f %10.1f %10.1f %10.1f %14.1f\n", t.name, bench::percentile(small, 0.5),
+               bench::percentile(small, 0.99), bench::percentile(large, 0.5), bench::percentile(large, 0.99), mbps);
+    }
+
+    for (shared_ptr<TcpServer> &server : servers) {
+        server->stop();
+    }
+    for (std::thread &th : loops) {
+        th.join();
+    }
+    return 0;
+}
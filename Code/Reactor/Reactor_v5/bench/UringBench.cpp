@@ -0,0 +1,275 @@
+// 小消息echo：epoll与io_uring完成模式对比，统计服务端每个请求的系统调用次数
+// 客户端线程用epoll同时驱动N个连接，每个连接始终有一条64字节请求在途，收齐回显再发下一条
+// 服务端单Reactor，链接时用--wrap截获loop线程里的read/write/epoll_wait/syscall(io_uring_enter)等
+// epoll：每个请求一次readv、一次writev，再加上分摊到的epoll_wait
+// io_uring：accept/recv由multishot请求完成，一轮的发送和等待合并成一次io_uring_enter
+// 用法：make bench && ./bench/uring_bench
+#include "../Logger.h"
+#include "../TcpConnection.h"
+#include "../TcpServer.h"
+#include "BenchUtil.h"
+#include <atomic>
+#include <cstdio>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <thread>
+
+namespace {
+
+const unsigned short kPort = 12396;
+const size_t kMsgSize = 64;
+const double kWarmupSec = 0.3;
+const double kMeasureSec = 2.0;
+
+std::atomic<bool> g_counting(false);
+std::atomic<uint64_t> g_syscalls(0);
+std::atomic<uint64_t> g_waits(0); // epoll_wait或io_uring_enter
+thread_local bool t_serverThread = false;
+
+inline void countSyscall(bool wait = false) {
+    if (t_serverThread && g_counting.load(std::memory_order_relaxed)) {
+        g_syscalls.fetch_add(1, std::memory_order_relaxed);
+        if (wait) {
+            g_waits.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace
+
+// 链接时-Wl,--wrap=read等把服务端代码中的调用转到这里，__real_*为原函数
+extern "C" {
+ssize_t __real_read(int, void *, size_t);
+ssize_t __real_readv(int, const struct iovec *, int);
+ssize_t __real_write(int, const void *, size_t);
+ssize_t __real_writev(int, const struct iovec *, int);
+ssize_t __real_send(int, const void *, size_t, int);
+ssize_t __real_sendmsg(int, const struct msghdr *, int);
+ssize_t __real_recvmsg(int, struct msghdr *, int);
+ssize_t __real_sendfile(int, int, off_t *, size_t);
+int __real_accept4(int, struct sockaddr *, socklen_t *, int);
+int __real_epoll_wait(int, struct epoll_event *, int, int);
+int __real_epoll_ctl(int, int, int, struct epoll_event *);
+int __real_setsockopt(int, int, int, const void *, socklen_t);
+int __real_getsockopt(int, int, int, void *, socklen_t *);
+int __real_getpeername(int, struct sockaddr *, socklen_t *);
+int __real_close(int);
+int __real_shutdown(int, int);
+int __real_fcntl(int, int, ...);
+int __real_timerfd_settime(int, int, const struct itimerspec *, struct itimerspec *);
+long __real_syscall(long, ...);
+
+ssize_t __wrap_read(int fd, void *buf, size_t len) {
+    countSyscall();
+    return __real_read(fd, buf, len);
+}
+
+ssize_t __wrap_readv(int fd, const struct iovec *iov, int iovcnt) {
+    countSyscall();
+    return __real_readv(fd, iov, iovcnt);
+}
+
+ssize_t __wrap_write(int fd, const void *buf, size_t len) {
+    countSyscall();
+    return __real_write(fd, buf, len);
+}
+
+ssize_t __wrap_writev(int fd, const struct iovec *iov, int iovcnt) {
+    countSyscall();
+    return __real_writev(fd, iov, iovcnt);
+}
+
+ssize_t __wrap_send(int fd, const void *buf, size_t len, int flags) {
+    countSyscall();
+    return __real_send(fd, buf, len, flags);
+}
+
+ssize_t __wrap_sendmsg(int fd, const struct msghdr *msg, int flags) {
+    countSyscall();
+    return __real_sendmsg(fd, msg, flags);
+}
+
+ssize_t __wrap_recvmsg(int fd, struct msghdr *msg, int flags) {
+    countSyscall();
+    return __real_recvmsg(fd, msg, flags);
+}
+
+ssize_t __wrap_sendfile(int outFd, int inFd, off_t *offset, size_t count) {
+    countSyscall();
+    return __real_sendfile(outFd, inFd, offset, count);
+}
+
+int __wrap_accept4(int fd, struct sockaddr *addr, socklen_t *len, int flags) {
+    countSyscall();
+    return __real_accept4(fd, addr, len, flags);
+}
+
+int __wrap_epoll_wait(int epfd, struct epoll_event *events, int maxEvents, int timeout) {
+    countSyscall(true);
+    return __real_epoll_wait(epfd, events, maxEvents, timeout);
+}
+
+int __wrap_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event) {
+    countSyscall();
+    return __real_epoll_ctl(epfd, op, fd, event);
+}
+
+int __wrap_setsockopt(int fd, int level, int name, const void *value, socklen_t len) {
+    countSyscall();
+    return __real_setsockopt(fd, level, name, value, len);
+}
+
+int __wrap_getsockopt(int fd, int level, int name, void *value, socklen_t *len) {
+    countSyscall();
+    return __real_getsockopt(fd, level, name, value, len);
+}
+
+int __wrap_getpeername(int fd, struct sockaddr *addr, socklen_t *len) {
+    countSyscall();
+    return __real_getpeername(fd, addr, len);
+}
+
+int __wrap_close(int fd) {
+    countSyscall();
+    return __real_close(fd);
+}
+
+int __wrap_shutdown(int fd, int how) {
+    countSyscall();
+    return __real_shutdown(fd, how);
+}
+
+int __wrap_fcntl(int fd, int cmd, ...) {
+    va_list ap;
+    va_start(ap, cmd);
+    long arg = va_arg(ap, long);
+    va_end(ap);
+    countSyscall();
+    return __real_fcntl(fd, cmd, arg);
+}
+
+int __wrap_timerfd_settime(int fd, int flags, const struct itimerspec *value, struct itimerspec *old) {
+    countSyscall();
+    return __real_timerfd_settime(fd, flags, value, old);
+}
+
+// IoUringPoller通过syscall()调用io_uring_enter，参数最多6个，全部按long转发
+long __wrap_syscall(long number, ...) {
+    va_list ap;
+    va_start(ap, number);
+    long args[6];
+    for (int i = 0; i < 6; ++i) {
+        args[i] = va_arg(ap, long);
+    }
+    va_end(ap);
+    countSyscall(number == __NR_io_uring_enter);
+    return __real_syscall(number, args[0], args[1], args[2], args[3], args[4], args[5]);
+}
+}
+
+namespace {
+
+struct Result {
+    double reqPerSec;
+    double syscallsPerReq;
+    double waitsPerReq;
+};
+
+// 每个连接收到的回显字节数，收齐kMsgSize算完成一个请求
+struct ClientConn {
+    int fd;
+    size_t got;
+};
+
+Result run(PollerType type, int conns) {
+    TcpServer server("127.0.0.1", kPort, 1024, 0, type);
+    server.setAllCallback(
+        functionCallback(), [](const shared_ptr<TcpConnection> &conn) { conn->send(conn->receive()); },
+        functionCallback());
+    std::thread loop([&server]() {
+        t_serverThread = true;
+        server.start();
+    });
+
+    vector<ClientConn> clients(conns);
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    string req(kMsgSize, 'q');
+    for (int i = 0; i < conns; ++i) {
+        clients[i].fd = bench::connectTcp(kPort);
+        clients[i].got = 0;
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, clients[i].fd, &ev);
+        write(clients[i].fd, req.data(), req.size());
+    }
+
+    uint64_t done = 0;
+    uint64_t startDone = 0;
+    double begin = bench::nowSec();
+    double measureBegin = 0;
+    struct epoll_event events[1024];
+    char buf[kMsgSize];
+    while (true) {
+        double now = bench::nowSec();
+        if (measureBegin == 0 && now - begin >= kWarmupSec) {
+            g_syscalls = 0;
+            g_waits = 0;
+            g_counting = true;
+            startDone = done;
+            measureBegin = now;
+        } else if (measureBegin > 0 && now - measureBegin >= kMeasureSec) {
+            g_counting = false;
+            break;
+        }
+        int n = epoll_wait(epfd, events, 1024, 100);
+        for (int i = 0; i < n; ++i) {
+            ClientConn &c = clients[events[i].data.u32];
+            ssize_t ret = read(c.fd, buf, kMsgSize - c.got);
+            if (ret <= 0) {
+                continue;
+            }
+            c.got += ret;
+            if (c.got == kMsgSize) {
+                c.got = 0;
+                ++done;
+                write(c.fd, req.data(), req.size());
+            }
+        }
+    }
+    double sec = bench::nowSec() - measureBegin;
+    uint64_t requests = done - startDone;
+
+    for (ClientConn &c : clients) {
+        close(c.fd);
+    }
+    close(epfd);
+    server.stop();
+    loop.join();
+
+    Result result;
+    result.reqPerSec = requests / sec;
+    result.syscallsPerReq = requests > 0 ? (double)g_syscalls / requests : 0;
+    result.waitsPerReq = requests > 0 ? (double)g_waits / requests : 0;
+    return result;
+}
+
+} // namespace
+
+int main() {
+    Logger::setLevel(kLogWarn);
+    printf("%-6s %-8s %12s %14s %14s\n", "连接", "后端", "请求/秒", "系统调用/请求", "其中等待/请求");
+    for (int conns : {1, 16, 256}) {
+        for (PollerType type : {PollerType::Epoll, PollerType::IoUring}) {
+            Result r = run(type, conns);
+            printf("%-6d %-8s %12.0f %14.2f %14.2f\n", conns, type == PollerType::Epoll ? "epoll" : "io_uring",
+                   r.reqPerSec, r.syscallsPerReq, r.waitsPerReq);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+// 流水线客户端的回复发送：原来每条回复一次write，现在每轮把积攒的回复合并成一次writev
+// 发送端和服务端一样开启TCP_NODELAY，每轮产生batch条回复，读端线程只负责读空
+// 报告每条回复的系统调用次数、TCP报文段数(TCP_INFO的tcpi_segs_out)和吞吐量
+// 用法：make bench && ./bench/writev_bench
+#include "BenchUtil.h"
+#include <climits>
+#include <cstdio>
+#include <string>
+#include <sys/uio.h>
+#include <thread>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+const size_t kReplies = 1000 * 1000;
+const size_t kReplySize = 64;
+
+struct Result {
+    double repliesPerSec;
+    double syscallsPerReply;
+    double segsPerReply;
+};
+
+// glibc的struct tcp_info停在tcpi_total_retrans，后面的字段按内核linux/tcp.h的布局补上
+// (linux/tcp.h与netinet/tcp.h不能同时包含)
+struct TcpInfoExt {
+    struct tcp_info base;
+    uint64_t pacingRate;
+    uint64_t maxPacingRate;
+    uint64_t bytesAcked;
+    uint64_t bytesReceived;
+    uint32_t segsOut; // 内核4.2起
+    uint32_t segsIn;
+};
+
+uint64_t segsOut(int fd) {
+    struct TcpInfoExt info;
+    socklen_t len = sizeof(info);
+    memset(&info, 0, sizeof(info));
+    getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len);
+    return info.segsOut;
+}
+
+bool writeAll(int fd, const char *data, size_t len, uint64_t *syscalls) {
+    while (len > 0) {
+        ++*syscalls;
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+// 和TcpConnection::flush一样：一次writev，没写完的部分从断开处继续
+bool writevAll(int fd, vector<struct iovec> &iov, uint64_t *syscalls) {
+    size_t first = 0;
+    while (first < iov.size()) {
+        ++*syscalls;
+        int cnt = (int)std::min(iov.size() - first, (size_t)IOV_MAX);
+        ssize_t n = writev(fd, &iov[first], cnt);
+        if (n <= 0) {
+            return false;
+        }
+        size_t left = n;
+        while (first < iov.size() && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            ++first;
+        }
+        if (left > 0) {
+            iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+    }
+    return true;
+}
+
+template <typename Sender>
+Result run(size_t batch, Sender &&sender) {
+    int fds[2];
+    if (!bench::tcpPair(fds)) {
+        perror("tcpPair");
+        return Result{0, 0, 0};
+    }
+    int opt = 1;
+    setsockopt(fds[1], IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    size_t total = kReplies / batch * batch;
+    std::thread reader([&]() {
+        char buf[65536];
+        size_t got = 0;
+        while (got < total * kReplySize) {
+            ssize_t n = read(fds[0], buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            got += n;
+        }
+    });
+    // 每条回复是一个独立的string，和输出队列中的消息一样
+    vector<string> replies(batch, string(kReplySize, 'r'));
+    uint64_t syscalls = 0;
+    uint64_t segsBefore = segsOut(fds[1]);
+    double begin = bench::nowSec();
+    for (size_t sent = 0; sent < total; sent += batch) {
+        if (!sender(fds[1], replies, &syscalls)) {
+            break;
+        }
+    }
+    reader.join();
+    double sec = bench::nowSec() - begin;
+    uint64_t segs = segsOut(fds[1]) - segsBefore;
+    close(fds[0]);
+    close(fds[1]);
+    return Result{total / sec, (double)syscalls / total, (double)segs / total};
+}
+
+}
+
+int main() {
+    printf("回复大小：%zu字节，共%zu条\n", kReplySize, kReplies);
+    printf("%8s %14s %12s %12s %14s %12s %12s\n", "每轮回复", "write(万/秒)", "调用/条", "报文段/条", "writev(万/秒)",
+           "调用/条", "报文段/条");
+    for (size_t batch : {1, 4, 16, 64, 256}) {
+        Result single = run(batch, [](int fd, vector<string> &replies, uint64_t *syscalls) {
+            for (const string &reply : replies) {
+                if (!writeAll(fd, reply.data(), reply.size(), syscalls)) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        vector<struct iovec> iov;
+        Result merged = run(batch, [&iov](int fd, vector<string> &replies, uint64_t *syscalls) {
+            iov.clear();
+            for (string &reply : replies) {
+                iov.push_back(iovec{&reply[0], reply.size()});
+            }
+            return writevAll(fd, iov, syscalls);
+        });
+        printf("%8zu %14.1f %12.3f %12.3f %14.1f %12.3f %12.3f\n", batch, single.repliesPerSec / 1e4,
+               single.syscallsPerReply, single.segsPerReply, merged.repliesPerSec / 1e4, merged.syscallsPerReply,
+               merged.segsPerReply);
+    }
+    return 0;
+}
@@ -1,8 +1,11 @@
 #include "HeadServer.h"
+#include "Logger.h"
 
 int main() {
-    HeadServer svr{3, 10, "127.0.0.1", 12345, 1024};
+    Logger::instance().start();
+    HeadServer svr{3, 10, "127.0.0.1", 12345, 1024, 2};
     svr.start();
     svr.stop();
+    Logger::instance().stop();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+// 边缘触发下一次收到超过64KB的数据：输入缓冲区被撑大后，readv只用缓冲区本身不用溢出区，
+// 读满它时内核中可能还有数据，必须继续读，否则不会再有新的边缘，连接卡住
+// 用法：make test
+#include "../Logger.h"
+#include "../TcpConnection.h"
+#include "../TcpServer.h"
+#include <arpa/inet.h>
+#include <cstdio>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+const unsigned short kPort = 12398;
+const int kRounds = 20;
+
+int connectServer() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    for (int i = 0; i < 50; ++i) {
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        usleep(20 * 1000);
+    }
+    close(fd);
+    return -1;
+}
+
+bool writeAll(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+// 同一个连接上每轮发一整块，等回显完整收到；超时说明服务端停在了内核缓冲区还有数据的地方
+bool echoRounds(int fd) {
+    struct timeval tv = {2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    string buf(1 << 20, '\0');
+    for (int round = 0; round < kRounds; ++round) {
+        size_t len = (size_t)(256 + round * 37) * 1024;
+        string msg(len, static_cast<char>('a' + round % 26));
+        // 回显和发送同时进行，另起线程写，避免双方的发送缓冲区都满了互相等待
+        bool sent = false;
+        std::thread writer([fd, &msg, &sent]() { sent = writeAll(fd, msg.data(), msg.size()); });
+        size_t got = 0;
+        bool ok = true;
+        while (got < len) {
+            ssize_t n = read(fd, &buf[0], buf.size());
+            if (n <= 0) {
+                printf("第%d轮：收到%zu/%zu字节后%s\n", round, got, len, n == 0 ? "连接关闭" : "超时");
+                ok = false;
+                break;
+            }
+            if (memcmp(buf.data(), msg.data(), n) != 0) {
+                printf("第%d轮：回显内容不一致\n", round);
+                ok = false;
+                break;
+            }
+            got += n;
+        }
+        if (!ok) {
+            shutdown(fd, SHUT_RDWR); // 让还在写的线程退出
+        }
+        writer.join();
+        if (!ok || !sent) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main() {
+    Logger::setLevel(kLogWarn);
+    TcpServer server("127.0.0.1", kPort, 64);
+    server.setEdgeTriggered(true);
+    server.setAllCallback(
+        functionCallback(),
+        [](const shared_ptr<TcpConnection> &conn) { conn->send(conn->receive()); },
+        functionCallback());
+    std::thread loop([&server]() { server.start(); });
+
+    int fd = connectServer();
+    bool ok = fd >= 0 && echoRounds(fd);
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    server.stop();
+    loop.join();
+    if (!ok) {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,96 @@
+// sendfile发送途中对端RST：sendfile不能带MSG_NOSIGNAL，服务端不能因SIGPIPE退出
+// 用法：make test
+#include "../Logger.h"
+#include "../TcpConnection.h"
+#include "../TcpServer.h"
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+const unsigned short kPort = 12399;
+const size_t kFileSize = 64 * 1024 * 1024;
+const int kRounds = 20;
+
+int connectServer() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    for (int i = 0; i < 50; ++i) {
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        usleep(20 * 1000);
+    }
+    close(fd);
+    return -1;
+}
+
+// 读到一部分文件后用SO_LINGER为0的close发送RST
+bool resetMidTransfer() {
+    int fd = connectServer();
+    if (fd < 0) {
+        return false;
+    }
+    char buf[65536];
+    size_t got = 0;
+    while (got < 256 * 1024) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            close(fd);
+            return false;
+        }
+        got += n;
+    }
+    struct linger lg = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(fd);
+    return true;
+}
+
+}
+
+int main() {
+    char path[] = "/tmp/sendfile_reset_XXXXXX";
+    int fileFd = mkstemp(path);
+    if (fileFd < 0 || ftruncate(fileFd, kFileSize) < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    unlink(path);
+
+    Logger::setLevel(kLogWarn);
+    TcpServer server("127.0.0.1", kPort, 64);
+    server.setAllCallback(
+        [fileFd](const shared_ptr<TcpConnection> &conn) { conn->sendFile(fileFd, 0, kFileSize); },
+        functionCallback(), functionCallback());
+    std::thread loop([&server]() { server.start(); });
+
+    int failed = 0;
+    for (int i = 0; i < kRounds; ++i) {
+        if (!resetMidTransfer()) {
+            ++failed;
+        }
+    }
+    // 服务端还活着并且还能正常发送
+    bool alive = resetMidTransfer();
+
+    server.stop();
+    loop.join();
+    close(fileFd);
+    if (failed > 0 || !alive) {
+        printf("FAIL: %d次传输失败，之后%s\n", failed, alive ? "服务端正常" : "服务端无响应");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,260 @@
+// io_uring完成模式：multishot accept、provided buffer的multishot recv和提交式发送下的回显
+// 多连接流水线回显；输出超过高水位时取消recv暂停读取，之后恢复，数据不能丢失或乱序；
+// 半关闭后回复发完再关闭；大回复发送途中客户端关闭，之后的新连接照常工作
+// 单Reactor和主从Reactor(带连接池)各跑一遍；内核不支持完成模式时退回就绪模式，同样应当通过
+// 用法：make test
+#include "../Logger.h"
+#include "../TcpConnection.h"
+#include "../TcpServer.h"
+#include <arpa/inet.h>
+#include <cstdio>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+const unsigned short kPort = 12397;
+const int kPipelineConns = 32;
+const size_t kPipelineBytes = 100 * 1024;
+const size_t kStreamBytes = 64 * 1024 * 1024;
+const size_t kBigReply = 32 * 1024 * 1024;
+const int kAbortRounds = 20;
+const int kChurnConns = 200;
+
+int connectServer() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    for (int i = 0; i < 50; ++i) {
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            struct timeval tv = {5, 0};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            return fd;
+        }
+        usleep(20 * 1000);
+    }
+    close(fd);
+    return -1;
+}
+
+bool writeAll(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool readAll(int fd, char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = read(fd, data, len);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+// 第i个字节的内容，错位或丢失都能发现
+char patternAt(size_t i, int seed) {
+    return static_cast<char>((i * 7 + i / 4093 + seed) % 251);
+}
+
+string pattern(size_t len, int seed) {
+    string data(len, '\0');
+    for (size_t i = 0; i < len; ++i) {
+        data[i] = patternAt(i, seed);
+    }
+    return data;
+}
+
+// 所有连接先各自写完，再逐个读回
+bool pipelineEcho() {
+    vector<int> fds;
+    for (int i = 0; i < kPipelineConns; ++i) {
+        int fd = connectServer();
+        if (fd < 0) {
+            printf("流水线：连接失败\n");
+            return false;
+        }
+        fds.push_back(fd);
+    }
+    bool ok = true;
+    for (int i = 0; i < kPipelineConns && ok; ++i) {
+        string data = pattern(kPipelineBytes, i);
+        // 分成大小不一的小段写，服务端每段一个recv完成事件
+        for (size_t off = 0, step = 1; off < data.size() && ok; off += step, step = step * 3 % 1500 + 1) {
+            ok = writeAll(fds[i], data.data() + off, std::min(step, data.size() - off));
+        }
+    }
+    string buf(kPipelineBytes, '\0');
+    for (int i = 0; i < kPipelineConns && ok; ++i) {
+        if (!readAll(fds[i], &buf[0], buf.size()) || buf != pattern(kPipelineBytes, i)) {
+            printf("流水线：第%d个连接回显不一致\n", i);
+            ok = false;
+        }
+    }
+    for (int fd : fds) {
+        close(fd);
+    }
+    return ok;
+}
+
+// 客户端先不读，服务端输出超过高水位后暂停读取，之后边读边校验
+bool slowReaderStream() {
+    int fd = connectServer();
+    if (fd < 0) {
+        printf("慢读：连接失败\n");
+        return false;
+    }
+    bool sent = false;
+    std::thread writer([fd, &sent]() {
+        string chunk(256 * 1024, '\0');
+        sent = true;
+        for (size_t off = 0; off < kStreamBytes && sent; off += chunk.size()) {
+            for (size_t i = 0; i < chunk.size(); ++i) {
+                chunk[i] = patternAt(off + i, 1);
+            }
+            sent = writeAll(fd, chunk.data(), chunk.size());
+        }
+    });
+    usleep(200 * 1000);
+    string buf(64 * 1024, '\0');
+    size_t got = 0;
+    bool ok = true;
+    while (got < kStreamBytes) {
+        ssize_t n = read(fd, &buf[0], buf.size());
+        if (n <= 0) {
+            printf("慢读：收到%zu/%zu字节后%s\n", got, kStreamBytes, n == 0 ? "连接关闭" : "超时");
+            ok = false;
+            break;
+        }
+        for (ssize_t i = 0; i < n; ++i) {
+            if (buf[i] != patternAt(got + i, 1)) {
+                printf("慢读：第%zu字节不一致\n", got + i);
+                ok = false;
+                break;
+            }
+        }
+        if (!ok) {
+            break;
+        }
+        got += n;
+    }
+    if (!ok) {
+        shutdown(fd, SHUT_RDWR);
+    }
+    writer.join();
+    close(fd);
+    return ok && sent;
+}
+
+// 半关闭：回复发完之后服务端关闭，客户端读到EOF
+bool halfClose() {
+    int fd = connectServer();
+    string msg = pattern(300 * 1024, 2);
+    if (fd < 0 || !writeAll(fd, msg.data(), msg.size())) {
+        printf("半关闭：发送失败\n");
+        return false;
+    }
+    shutdown(fd, SHUT_WR);
+    string buf(msg.size(), '\0');
+    char extra;
+    bool ok = readAll(fd, &buf[0], buf.size()) && buf == msg && read(fd, &extra, 1) == 0;
+    close(fd);
+    if (!ok) {
+        printf("半关闭：回显不完整或没有关闭\n");
+    }
+    return ok;
+}
+
+// 大回复还在发送时客户端关闭，然后新连接回显
+bool abortDuringSend() {
+    for (int round = 0; round < kAbortRounds; ++round) {
+        int fd = connectServer();
+        char buf[4096];
+        if (fd < 0 || !writeAll(fd, "BIG\n", 4) || read(fd, buf, sizeof(buf)) <= 0) {
+            printf("中途关闭：第%d轮没有收到回复\n", round);
+            return false;
+        }
+        // 接收缓冲区里还有数据，close发出RST
+        close(fd);
+        fd = connectServer();
+        if (fd < 0 || !writeAll(fd, "ping", 4) || !readAll(fd, buf, 4) || memcmp(buf, "ping", 4) != 0) {
+            printf("中途关闭：第%d轮之后的新连接没有回显\n", round);
+            return false;
+        }
+        close(fd);
+    }
+    return true;
+}
+
+// 连接反复建立关闭，fd被复用，旧连接的请求不能影响新连接
+bool churn() {
+    for (int i = 0; i < kChurnConns; ++i) {
+        int fd = connectServer();
+        string msg = pattern(100 + i, i);
+        string buf(msg.size(), '\0');
+        if (fd < 0 || !writeAll(fd, msg.data(), msg.size()) || !readAll(fd, &buf[0], buf.size()) || buf != msg) {
+            printf("短连接：第%d个连接回显失败\n", i);
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+        close(fd);
+    }
+    return true;
+}
+
+bool runAll(size_t ioThreads) {
+    TcpServer server("127.0.0.1", kPort, 64, ioThreads, PollerType::IoUring);
+    server.setWaterMarks(256 * 1024, 64 * 1024);
+    if (ioThreads > 0) {
+        server.setConnectionPool(64);
+    }
+    server.setAllCallback(
+        functionCallback(),
+        [](const shared_ptr<TcpConnection> &conn) {
+            string msg = conn->receive();
+            if (msg == "BIG\n") {
+                conn->send(string(kBigReply, 'x'));
+            } else {
+                conn->send(std::move(msg));
+            }
+        },
+        functionCallback());
+    std::thread loop([&server]() { server.start(); });
+    usleep(100 * 1000);
+
+    bool ok = pipelineEcho() && slowReaderStream() && halfClose() && abortDuringSend() && churn();
+
+    server.stop();
+    loop.join();
+    return ok;
+}
+
+}
+
+int main() {
+    Logger::setLevel(kLogWarn);
+    bool ok = runAll(0) && runAll(2);
+    if (!ok) {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}